@@ -0,0 +1,209 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Benchmark comparing the greedy and the dynamic programming solver of the
+ * global optimization.
+ *
+ * Random scalability graphs are generated for each client. For each problem
+ * size, the accumulated speedup (throughput) of the resulting distributions
+ * and the time to compute them is printed.
+ *
+ * With more than one thread, the time of the parallel solvers is printed additionally.
+ */
+
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../server/CGlobalOptimizer.hpp"
+
+
+
+/**
+ * scalability graph following Amdahl's law (concave)
+ */
+void setupAmdahl(
+		std::vector<double> &o_values,
+		int i_max_cores
+)
+{
+	double serial = 0.01 + 0.2*drand48();
+
+	o_values.assign(i_max_cores+1, 0);
+	for (int n = 1; n <= i_max_cores; n++)
+		o_values[n] = 1.0/(serial + (1.0-serial)/(double)n);
+}
+
+
+
+/**
+ * scalability graph with sweet spots at powers of two (e.g. domain decomposition)
+ *
+ * the speedup only increases if the next power of two is reached
+ */
+void setupPowerOfTwo(
+		std::vector<double> &o_values,
+		int i_max_cores
+)
+{
+	double efficiency = 0.7 + 0.3*drand48();
+
+	o_values.assign(i_max_cores+1, 0);
+	for (int n = 1; n <= i_max_cores; n++)
+	{
+		int p = 1;
+		while (p*2 <= n)
+			p *= 2;
+
+		o_values[n] = std::pow((double)p, efficiency);
+	}
+}
+
+
+
+/**
+ * scalability graph with a jump after a setup overhead (e.g. a dedicated communication thread)
+ */
+void setupJump(
+		std::vector<double> &o_values,
+		int i_max_cores
+)
+{
+	int jump = 2 + (int)(drand48()*8.0);
+
+	o_values.assign(i_max_cores+1, 0);
+	for (int n = 1; n <= i_max_cores; n++)
+	{
+		if (n < jump)
+			o_values[n] = 1.0 + 0.05*(double)(n-1);
+		else
+			o_values[n] = 0.9*(double)n;
+	}
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	int num_repetitions = 10;
+	int num_threads = 1;
+
+	char optchar;
+	while ((optchar = getopt(argc, argv, "j:r:")) > 0)
+	{
+		switch(optchar)
+		{
+		case 'r':
+			num_repetitions = atoi(optarg);
+			break;
+
+		case 'j':
+			num_threads = atoi(optarg);
+			break;
+
+		default:
+			std::cout << "usage: " << argv[0] << std::endl;
+			std::cout << "	[-r [int]: number of random problems for each problem size, default: 10]" << std::endl;
+			std::cout << "	[-j [int]: number of threads for the parallel solvers, default: 1]" << std::endl;
+			return -1;
+		}
+	}
+
+	srand48(0);
+
+	CGlobalOptimizer cGlobalOptimizer;
+	cGlobalOptimizer.num_threads = num_threads;
+
+	int num_clients_list[] = {2, 4, 8, 16, 32, 128};
+	int num_cores_list[] = {16, 64, 256, 1024};
+
+	std::cout << "clients	cores	greedy_throughput	dp_throughput	improvement	greedy_seconds	dp_seconds";
+	if (num_threads > 1)
+		std::cout << "	greedy_parallel_seconds	dp_parallel_seconds";
+	std::cout << std::endl;
+
+	for (int ci = 0; ci < (int)(sizeof(num_clients_list)/sizeof(int)); ci++)
+	{
+		for (int ni = 0; ni < (int)(sizeof(num_cores_list)/sizeof(int)); ni++)
+		{
+			int num_clients = num_clients_list[ci];
+			int num_cores = num_cores_list[ni];
+
+			if (num_clients > num_cores)
+				continue;
+
+			double sum_greedy = 0;
+			double sum_dp = 0;
+			double seconds_greedy = 0;
+			double seconds_dp = 0;
+			double seconds_greedy_parallel = 0;
+			double seconds_dp_parallel = 0;
+
+			for (int r = 0; r < num_repetitions; r++)
+			{
+				cGlobalOptimizer.resize(num_clients, num_cores);
+
+				for (int c = 0; c < num_clients; c++)
+				{
+					switch(c % 3)
+					{
+					case 0:	setupAmdahl(cGlobalOptimizer.values[c], num_cores);		break;
+					case 1:	setupPowerOfTwo(cGlobalOptimizer.values[c], num_cores);	break;
+					case 2:	setupJump(cGlobalOptimizer.values[c], num_cores);		break;
+					}
+
+					cGlobalOptimizer.lower[c] = 1;
+					cGlobalOptimizer.upper[c] = num_cores;
+				}
+
+				std::vector<int> distribution;
+				CStopwatch cStopwatch;
+
+				cStopwatch.start();
+				cGlobalOptimizer.solveGreedy(distribution);
+				seconds_greedy += cStopwatch.getTimeSinceStart();
+				sum_greedy += cGlobalOptimizer.computeObjective(distribution);
+
+				cStopwatch.start();
+				cGlobalOptimizer.solveDP(distribution);
+				seconds_dp += cStopwatch.getTimeSinceStart();
+				sum_dp += cGlobalOptimizer.computeObjective(distribution);
+
+				if (num_threads > 1)
+				{
+					cStopwatch.start();
+					cGlobalOptimizer.solveGreedyParallel(distribution);
+					seconds_greedy_parallel += cStopwatch.getTimeSinceStart();
+
+					cStopwatch.start();
+					cGlobalOptimizer.solveDP(distribution, -1, true);
+					seconds_dp_parallel += cStopwatch.getTimeSinceStart();
+				}
+			}
+
+			std::cout << num_clients << "	" << num_cores << "	";
+			std::cout << sum_greedy/(double)num_repetitions << "	";
+			std::cout << sum_dp/(double)num_repetitions << "	";
+			std::cout << sum_dp/sum_greedy << "	";
+			std::cout << seconds_greedy/(double)num_repetitions << "	";
+			std::cout << seconds_dp/(double)num_repetitions;
+
+			if (num_threads > 1)
+			{
+				std::cout << "	" << seconds_greedy_parallel/(double)num_repetitions;
+				std::cout << "	" << seconds_dp_parallel/(double)num_repetitions;
+			}
+
+			std::cout << std::endl;
+		}
+	}
+
+	return 0;
+}
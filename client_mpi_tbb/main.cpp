@@ -28,6 +28,7 @@
 
 #include "../server/CWorldScheduler_threaded.hpp"
 #include "../include/CDummyWorkload.hpp"
+#include "../include/CPMO_PMPI.hpp"
 #include <mpi.h>
 
 
@@ -57,6 +58,26 @@ int main(int argc, char *argv[])
 	if (argc > 2)
 		verbose_level = atoi(argv[2]);
 
+	// request cores to equalize the finish times of the ranks instead of using the workload as distribution hint
+	int use_deadline = 0;
+	if (argc > 3)
+		use_deadline = atoi(argv[3]);
+
+	// lend the cores of ranks waiting in blocking MPI calls to the other ranks
+	int use_lending = 0;
+	if (argc > 4)
+		use_lending = atoi(argv[4]);
+
+	// allocate the cores for all ranks as a single group progressing at the pace of the slowest rank
+	int use_group = 0;
+	if (argc > 5)
+		use_group = atoi(argv[5]);
+
+	// precompute the solutions of the global optimization for the predicted workloads of the next timestep
+	int use_prediction = 0;
+	if (argc > 6)
+		use_prediction = atoi(argv[6]);
+
 	/*
 	 * initialize MPI
 	 */
@@ -67,7 +88,7 @@ int main(int argc, char *argv[])
 
 	if (size == 1)
 	{
-		std::cout << "run with `mpirun -n 2 ./build/client_mpi_tbb_release [use invasic (0/1)] [verbose level (-99 for fancy graphics)]`" << std::endl;
+		std::cout << "run with `mpirun -n 2 ./build/client_mpi_tbb_release [use invasic (0/1)] [verbose level (-99 for fancy graphics)] [use deadline (0/1)] [lend cores in MPI calls (0/1)] [couple ranks as group (0/1)] [predict workloads (0/1)]`" << std::endl;
 		return -1;
 	}
 
@@ -85,7 +106,7 @@ int main(int argc, char *argv[])
 				cWorldScheduler_threaded = new CWorldScheduler_threaded;
 
 				std::cout << "RANK 0: starting worldscheduler" << std::endl;
-				cWorldScheduler_threaded->start(-1, verbose_level, true);
+				cWorldScheduler_threaded->start(-1, verbose_level, true, nullptr, false, 0, use_prediction ? 16 : 0);
 			}
 		}
 
@@ -97,6 +118,17 @@ int main(int argc, char *argv[])
 		/*
 		 * initialize iPMO client
 		 */
+		if (use_group)
+		{
+			// group id shared by all ranks of this job
+			int group_id = getpid();
+			MPI_Bcast(&group_id, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+			char group_id_str[32];
+			snprintf(group_id_str, sizeof(group_id_str), "%d", group_id);
+			setenv("IPMO_GROUP_ID", group_id_str, 1);
+		}
+
 #if USE_OMP
 		cPmo = new CPMO_OMP(max_threads);
 #else
@@ -105,6 +137,9 @@ int main(int argc, char *argv[])
 
 		// initial setup request
 		cPmo->invade_blocking(1, 1024, 0, nullptr, (float)1);
+
+		if (use_lending)
+			CPMO_PMPI::setup(cPmo);
 	}
 
 
@@ -134,7 +169,10 @@ int main(int argc, char *argv[])
 			cPmo->reinvade_nonblocking();
 
 			// request resource update with new workload
-			cPmo->invade_nonblocking(1, 1024, 0, nullptr, (float)workload);
+			if (use_deadline)
+				cPmo->invade_deadline_nonblocking(1, 1024, (float)workload);
+			else
+				cPmo->invade_nonblocking(1, 1024, 0, nullptr, (float)workload);
 		}
 
 
@@ -189,6 +227,7 @@ int main(int argc, char *argv[])
 		/*
 		 * free iPMO client
 		 */
+		CPMO_PMPI::setup(nullptr);
 		delete cPmo;
 
 		// wait for all clients to shutdown iPMO
@@ -18,6 +18,8 @@
 #include <cassert>
 #include <signal.h>
 #include <vector>
+#include <algorithm>
+#include <poll.h>
 
 
 #include "../include/CPMO_OMP.hpp"
@@ -282,6 +284,571 @@ void run6_shutdown(
 
 
 
+void run8_setup(
+		int max_threads,
+		int workload
+)
+{
+	std::cout << "RUN 8: setup" << std::endl;
+
+	// start without any scalability graph and learn it online
+	cPmo->invade(1, 1024, 0, nullptr);
+
+	cPmo->scalability_learning_setup(1, 1024, 5);
+}
+
+
+void run8_loop(
+		int max_threads,
+		int workload
+)
+{
+	std::cout << "RUN 8 (learn scalability graph)" << std::endl;
+
+	cPmo->reinvade_nonblocking();
+
+	cPmo->timestep_begin();
+
+	// fixed number of work units which are distributed among all threads
+	int work_units = 64;
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < work_units; i++)
+		CDummyWorkload::doSomeSqrt(918238123.0, workload);
+
+	cPmo->timestep_end(work_units);
+}
+
+void run8_shutdown(
+		int max_threads,
+		int workload
+)
+{
+	std::cout << "RUN 8: shutdown" << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+
+/**
+ * latency benchmark for priority classes
+ *
+ * each request processes a fixed number of work units with all available threads.
+ * start this test once with priority class 0 and once with priority class 1
+ * (second program parameter) while batch clients (e.g. test 17) are running
+ * and compare the latency percentiles.
+ */
+void run9(
+		int max_threads,
+		int workload,
+		int priority_class,
+		int num_requests
+)
+{
+	std::cout << "RUN 9 (request latency with priority class " << priority_class << ")" << std::endl;
+
+	cPmo->setPriority(priority_class);
+	cPmo->invade(1, 1024, 0, nullptr);
+
+	std::vector<double> latencies;
+
+	for (int r = 0; r < num_requests; r++)
+	{
+		CStopwatch cStopwatch;
+		cStopwatch.start();
+
+		cPmo->reinvade_nonblocking();
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < 16; i++)
+			CDummyWorkload::doSomeSqrt(918238123.0, workload);
+
+		latencies.push_back(cStopwatch.getTimeSinceStart());
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << "LATENCY p50: " << latencies[latencies.size()*50/100] << std::endl;
+	std::cout << "LATENCY p90: " << latencies[latencies.size()*90/100] << std::endl;
+	std::cout << "LATENCY p99: " << latencies[latencies.size()*99/100] << std::endl;
+	std::cout << "LATENCY max: " << latencies.back() << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+
+
+/**
+ * testrun 10:
+ * asynchronous invades overlapping the resource negotiation with computation
+ *
+ * the number of cores is changed with each request. work units are processed
+ * with the current threads until the answer of the server was received.
+ */
+void run10(
+		int max_threads,
+		int workload,
+		int num_requests
+)
+{
+	std::cout << "RUN 10 (asynchronous invade)" << std::endl;
+
+	int overlapped_work_units = 0;
+
+	for (int r = 0; r < num_requests; r++)
+	{
+		CPMOFuture f = cPmo->invade_async(1, (r % 2 == 0 ? 1024 : 1));
+
+		while (!f.ready())
+		{
+			#pragma omp parallel for schedule(dynamic, 1)
+			for (int i = 0; i < 4; i++)
+				CDummyWorkload::doSomeSqrt(918238123.0, workload);
+
+			overlapped_work_units++;
+		}
+
+		f.get();
+
+		std::cout << "REQUEST " << r << ": " << cPmo->getNumberOfThreads() << " threads" << std::endl;
+	}
+
+	std::cout << "OVERLAPPED WORK UNITS: " << overlapped_work_units << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+
+
+/**
+ * testrun 11:
+ * sleep in poll() on the notification socket until the resources change
+ *
+ * start other clients (e.g. test 26) to trigger resource updates.
+ */
+void run11(
+		int max_threads,
+		int workload,
+		int num_updates
+)
+{
+	std::cout << "RUN 11 (wait for resource update notifications)" << std::endl;
+
+	int fd = cPmo->setupNotification();
+	if (fd < 0)
+	{
+		std::cerr << "notification socket not available" << std::endl;
+		return;
+	}
+
+	cPmo->invade(1, 1024, 0, nullptr);
+
+	int updates = 0;
+	int timeouts = 0;
+
+	while (updates < num_updates && timeouts < 30)
+	{
+		struct pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+
+		if (poll(&pfd, 1, 1000) <= 0)
+		{
+			timeouts++;
+			continue;
+		}
+
+		if (cPmo->handleNotification())
+		{
+			updates++;
+			std::cout << "RESOURCE UPDATE " << updates << ": " << cPmo->getNumberOfThreads() << " threads" << std::endl;
+
+			#pragma omp parallel
+			CDummyWorkload::doSomeSqrt(918238123.0, workload);
+		}
+	}
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+
+/**
+ * long running parallel loop with checkpoints between the chunks
+ */
+void run12(
+		int max_threads,
+		int workload,
+		int num_chunks
+)
+{
+	std::cout << "RUN 12 (chunked parallel loop with checkpoints)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	int chunk_size = cPmo->getMaxNumberOfThreads();
+
+	cPmo->parallel_for_chunked(
+			0, num_chunks*chunk_size, chunk_size,
+			[&workload](int i)
+			{
+				CDummyWorkload::doSomeSqrt(918238123.0, workload);
+			}
+		);
+
+	std::cout << "THREADS AFTER LOOP: " << cPmo->getNumberOfThreads() << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * alternating parallel and serial phases, the cores are lent to other
+ * clients by the idle detection during the serial phases
+ */
+void run13(
+		int max_threads,
+		int workload,
+		int num_phases
+)
+{
+	std::cout << "RUN 13 (idle detection)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	cPmo->setupIdleDetection(0.05);
+
+	for (int p = 0; p < num_phases; p++)
+	{
+		cPmo->parallel_for_chunked(
+				0, 4*cPmo->getMaxNumberOfThreads(), cPmo->getMaxNumberOfThreads(),
+				[&workload](int i)
+				{
+					CDummyWorkload::doSomeSqrt(918238123.0, workload);
+				}
+			);
+
+		std::cout << "PARALLEL PHASE " << p << ": " << cPmo->getNumberOfThreads() << " threads" << std::endl;
+
+		// serial phase
+		usleep(200000);
+	}
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * NUMA aware allocation for the current cores: print the planned and the
+ * actual NUMA domains of the blocks of a partitioned buffer after the first
+ * touch (e.g. with IPMO_NUMA_TOPOLOGY="0-1;2-3" for a simulated topology)
+ */
+void run14(
+		int max_threads,
+		size_t size
+)
+{
+	std::cout << "RUN 14 (NUMA aware allocation)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	int num_threads = cPmo->getNumberOfThreads();
+
+	char *buffer = (char*)cPmo->numaAllocatePartitioned(size);
+	double *shared = (double*)cPmo->numaAllocateInterleaved(sizeof(double)*1024);
+	std::vector<char*> local(num_threads);
+
+	#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < size; i++)
+		buffer[i] = 1;
+
+	#pragma omp parallel
+	{
+		int id = omp_get_thread_num();
+		local[id] = (char*)cPmo->numaAllocateLocal(4096, id);
+		local[id][0] = 1;
+	}
+
+	for (int i = 0; i < 1024; i++)
+		shared[i] = i;
+
+	std::vector<int> planned_nodes = cPmo->getNumaArena()->getBlockNodes(buffer);
+
+	for (int i = 0; i < num_threads; i++)
+	{
+		void *page = buffer + size*i/num_threads;
+		int status = -1;
+		syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0);
+
+		std::cout << "BLOCK " << i << ": planned NUMA domain " << planned_nodes[i] << ", actual NUMA domain " << status << std::endl;
+	}
+
+	for (int i = 0; i < num_threads; i++)
+		cPmo->numaFree(local[i]);
+
+	cPmo->numaFree(shared);
+	cPmo->numaFree(buffer);
+
+	cPmo->client_shutdown_hint = size;
+}
+
+
+
+/**
+ * invade with backoff: if no core is free, the client is queued by the
+ * server and continues with a single thread until it was admitted
+ */
+void run15(
+		int max_threads,
+		int workload,
+		int iterations
+)
+{
+	std::cout << "RUN 15 (invade with admission queue backoff)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->setupInvadeQueueBackoff();
+	cPmo->invade(1, 1024, v1);
+
+	for (int j = 0; j < iterations; j++)
+	{
+		if (cPmo->getInvadeQueuePosition() > 0)
+			std::cout << "QUEUED AT POSITION " << cPmo->getInvadeQueuePosition() << std::endl;
+
+		cPmo->reinvade_nonblocking();
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < 64; i++)
+			CDummyWorkload::doSomeSqrt(918238123.0, workload);
+	}
+
+	std::cout << "THREADS AFTER LOOP: " << cPmo->getNumberOfThreads() << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * testrun 16: invades with a periodic workload given as distribution hint
+ * (see server option -P)
+ */
+void run16(
+		int max_threads,
+		int workload,
+		int iterations
+)
+{
+	std::cout << "RUN 16 (invade with periodic distribution hints)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	for (int j = 0; j < iterations; j++)
+	{
+		float hint = (float)(1 + j % 3);
+
+		cPmo->invade_blocking(1, 1024, v1.size(), v1.data(), hint);
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < 16*(int)hint; i++)
+			CDummyWorkload::doSomeSqrt(918238123.0, workload);
+	}
+
+	std::cout << "THREADS AFTER LOOP: " << cPmo->getNumberOfThreads() << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * benchmark: fixed number of work units of the dummy workload which are
+ * distributed among all threads while the resources are updated with
+ * nonblocking reinvades (see also test 40 of the threads client)
+ */
+void runBenchmark(
+		int max_threads,
+		int workload,
+		int iterations
+)
+{
+	std::cout << "RUN BENCHMARK (dummy workload)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	int work_units = 64;
+
+	CStopwatch stopwatch;
+	stopwatch.reset();
+	stopwatch.start();
+
+	for (int j = 0; j < iterations; j++)
+	{
+		cPmo->reinvade_nonblocking();
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < work_units; i++)
+			CDummyWorkload::doSomeSqrt(918238123.0, workload);
+	}
+
+	stopwatch.stop();
+
+	std::cout << "BENCHMARK: " << stopwatch.time/(double)iterations << " seconds per iteration with " << cPmo->getNumberOfThreads() << " threads" << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * micro-benchmark of the resize latency: alternate between a single thread
+ * and all threads, first with unchanged cpus (pin-skip cache) and then with
+ * rotated cpus. each resize is followed by an empty parallel region.
+ */
+void runResizeBenchmark(
+		int max_threads,
+		int iterations
+)
+{
+	std::cout << "RUN RESIZE BENCHMARK" << std::endl;
+
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+
+	std::vector<int> cpus;
+	for (int i = 0; i < CPU_SETSIZE; i++)
+		if (CPU_ISSET(i, &cpu_set))
+			cpus.push_back(i);
+
+	int n = cPmo->getMaxNumberOfThreads();
+
+	for (int rotate = 0; rotate < 2; rotate++)
+	{
+		CStopwatch stopwatch;
+		stopwatch.reset();
+
+		std::vector<int> affinities(n);
+
+		for (int j = 0; j < iterations; j++)
+		{
+			int num_threads = (j & 1 ? n : 1);
+
+			for (int i = 0; i < n; i++)
+				affinities[i] = cpus[(i + rotate*j) % cpus.size()];
+
+			stopwatch.start();
+
+			cPmo->setNumberOfThreads(num_threads);
+			cPmo->setAffinities(affinities.data(), num_threads);
+
+			#pragma omp parallel
+			{
+			}
+
+			stopwatch.stop();
+		}
+
+		std::cout << "RESIZE LATENCY (" << (rotate ? "changed" : "unchanged") << " cpus): " << stopwatch.time*1000000.0/(double)iterations << " us" << std::endl;
+	}
+
+	cPmo->setNumberOfThreads(1);
+	cPmo->setAffinities(&cpus[0], 1);
+
+	cPmo->client_shutdown_hint = iterations;
+}
+
+
+
+/**
+ * benchmark of the memory bandwidth with migration of the buffer: the
+ * bandwidth of a statically partitioned sum over a large buffer is printed
+ * for each iteration. after the server moved the cores to other NUMA
+ * domains (e.g. by starting and stopping other clients), the bandwidth
+ * recovers once the pages were migrated to the new domains.
+ */
+void runMigrationBenchmark(
+		int max_threads,
+		size_t size,
+		int iterations
+)
+{
+	std::cout << "RUN MIGRATION BENCHMARK" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	size_t n = size/sizeof(double);
+	double *buffer = new double[n];
+
+	// first touch
+	#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < n; i++)
+		buffer[i] = 1.0;
+
+	cPmo->setupMemoryMigration();
+	cPmo->registerMemoryBuffer(buffer, n*sizeof(double));
+
+	for (int j = 0; j < iterations; j++)
+	{
+		cPmo->reinvade_nonblocking();
+
+		CStopwatch stopwatch;
+		stopwatch.reset();
+		stopwatch.start();
+
+		double sum = 0;
+
+		#pragma omp parallel for schedule(static) reduction(+:sum)
+		for (size_t i = 0; i < n; i++)
+			sum += buffer[i];
+
+		stopwatch.stop();
+
+		std::cout << "BANDWIDTH: " << (double)(n*sizeof(double))/(stopwatch.time*1024.0*1024.0*1024.0) << " GB/s with " << cPmo->getNumberOfThreads() << " threads (sum " << sum << ")" << std::endl;
+	}
+
+	cPmo->unregisterMemoryBuffer(buffer);
+	delete [] buffer;
+
+	cPmo->client_shutdown_hint = iterations;
+}
+
+
+
 int main(int argc, char *argv[])
 {
 	/*
@@ -300,6 +867,10 @@ int main(int argc, char *argv[])
 		test_program = atoi(argv[1]);
 	}
 
+	int priority_class = 0;
+	if (argc > 2)
+		priority_class = atoi(argv[2]);
+
 
 	cPmo = new CPMO_OMP(max_threads);
 	cPmo->setup();
@@ -342,6 +913,20 @@ int main(int argc, char *argv[])
 		run6_shutdown(max_threads, 40000);
 		break;
 
+	case 8:
+		run8_setup(max_threads, 4000);
+		for (int i = 0; i < 10; i++)
+			run8_loop(max_threads, 4000);
+		run8_shutdown(max_threads, 4000);
+		break;
+
+	case 9:
+		run9(max_threads, 4000, priority_class, 20);
+		break;
+
+	case 10:
+		run10(max_threads, 4000, 10);
+		break;
 
 
 	case 11:
@@ -391,6 +976,14 @@ int main(int argc, char *argv[])
 		run6_shutdown(max_threads, 40000);
 		break;
 
+	case 18:
+		run8_setup(max_threads, 4000);
+		while (true)
+			run8_loop(max_threads, 4000);
+
+		run8_shutdown(max_threads, 4000);
+		break;
+
 
 
 	case 21:
@@ -446,6 +1039,68 @@ int main(int argc, char *argv[])
 		run6_shutdown(max_threads, 4000);
 		cPmo->client_shutdown_hint = 4000*20;
 		break;
+
+	case 28:
+		run8_setup(max_threads, 4000);
+
+		for (int i = 0; i < 100; i++)
+			run8_loop(max_threads, 4000);
+
+		run8_shutdown(max_threads, 4000);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 29:
+		run9(max_threads, 1000, priority_class, 1000);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 30:
+		run10(max_threads, 1000, 100);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 31:
+		run11(max_threads, 1000, 10);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 32:
+		run12(max_threads, 200, 1000);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 33:
+		run13(max_threads, 200, 10);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 34:
+		run14(max_threads, 64*1024*1024);
+		break;
+
+	case 35:
+		run15(max_threads, 200, 100);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 36:
+		run16(max_threads, 200, 100);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 40:
+		runBenchmark(max_threads, 200, 100);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 41:
+		runResizeBenchmark(max_threads, 1000);
+		break;
+
+	case 42:
+		runMigrationBenchmark(max_threads, 256*1024*1024, 100);
+		break;
 	}
 
     cPmo->retreat();
@@ -297,6 +297,116 @@ void run6_shutdown(
 
 
 
+/**
+ * benchmark: fixed number of work units of the dummy workload which are
+ * distributed among all threads while the resources are updated with
+ * nonblocking reinvades (see also test 40 of the threads client)
+ */
+void runBenchmark(
+		int max_threads,
+		int workload,
+		int iterations
+)
+{
+	std::cout << "RUN BENCHMARK (dummy workload)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	int work_units = 64;
+
+	CStopwatch stopwatch;
+	stopwatch.reset();
+	stopwatch.start();
+
+	for (int j = 0; j < iterations; j++)
+	{
+		cPmo->reinvade_nonblocking();
+
+		tbb::parallel_for(
+				0, work_units, 1,
+				[&workload](int i)
+				{
+					CDummyWorkload::doSomeSqrt(918238123.0, workload);
+				}
+			);
+	}
+
+	stopwatch.stop();
+
+	std::cout << "BENCHMARK: " << stopwatch.time/(double)iterations << " seconds per iteration with " << cPmo->getNumberOfThreads() << " threads" << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * micro-benchmark of the resize latency: alternate between a single thread
+ * and all threads, first with unchanged cpus (pin-skip cache) and then with
+ * rotated cpus. each resize is followed by an empty parallel region.
+ */
+void runResizeBenchmark(
+		int max_threads,
+		int iterations
+)
+{
+	std::cout << "RUN RESIZE BENCHMARK" << std::endl;
+
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+
+	std::vector<int> cpus;
+	for (int i = 0; i < CPU_SETSIZE; i++)
+		if (CPU_ISSET(i, &cpu_set))
+			cpus.push_back(i);
+
+	int n = cPmo->getMaxNumberOfThreads();
+
+	for (int rotate = 0; rotate < 2; rotate++)
+	{
+		CStopwatch stopwatch;
+		stopwatch.reset();
+
+		std::vector<int> affinities(n);
+
+		for (int j = 0; j < iterations; j++)
+		{
+			int num_threads = (j & 1 ? n : 1);
+
+			for (int i = 0; i < n; i++)
+				affinities[i] = cpus[(i + rotate*j) % cpus.size()];
+
+			stopwatch.start();
+
+			cPmo->setNumberOfThreads(num_threads);
+			cPmo->setAffinities(affinities.data(), num_threads);
+
+			tbb::parallel_for(
+					0, num_threads, 1,
+					[](int i)
+					{
+					}
+				);
+
+			stopwatch.stop();
+		}
+
+		std::cout << "RESIZE LATENCY (" << (rotate ? "changed" : "unchanged") << " cpus): " << stopwatch.time*1000000.0/(double)iterations << " us" << std::endl;
+	}
+
+	cPmo->setNumberOfThreads(1);
+	cPmo->setAffinities(&cpus[0], 1);
+
+	cPmo->client_shutdown_hint = iterations;
+}
+
+
+
 int main(int argc, char *argv[])
 {
 	int max_threads = -1;
@@ -505,6 +615,15 @@ int main(int argc, char *argv[])
 		run6_shutdown(max_threads, 4000);
 		cPmo->client_shutdown_hint = 4000*20;
 		break;
+
+	case 40:
+		runBenchmark(max_threads, 200, 100);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 41:
+		runResizeBenchmark(max_threads, 1000);
+		break;
 	}
 
     cPmo->retreat();
@@ -0,0 +1,343 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+
+#include <iostream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cassert>
+#include <vector>
+
+
+#include "../include/CPMO_Threads.hpp"
+#include "../include/CDummyWorkload.hpp"
+#include "../include/CStopwatch.hpp"
+
+CPMO_Threads *cPmo = 0;
+
+/**
+ * testrun 1:
+ */
+void run1(int max_threads = -1, int workload = 40000)
+{
+	std::cout << "RUN 1 (invade/-)" << std::endl;
+
+	double *a = new double[cPmo->getMaxNumberOfThreads()];
+
+	std::vector<float> v1(20, 0);
+	float s = 1.0;
+
+	std::cout << "Scalability graph: ";
+	for (int i = 0; i < 20; i++)
+	{
+		v1[i] = s;
+		s += 0.1+0.2*4.0/((double)((i+2)*(i+3)));
+
+		std::cout << v1[i] << " ";
+	}
+	std::cout << std::endl;
+
+	cPmo->invade(1, 1024, v1);
+
+	cPmo->parallel_for(
+			0, cPmo->getNumberOfThreads(), 1,
+			[a, &workload](int i)
+			{
+				a[i] = CDummyWorkload::doSomeSqrt(918238123.0, workload);
+			}
+		);
+
+	for (int i = 0; i < cPmo->getNumberOfThreads(); i++)
+		std::cout << "RESULT (" << i << "): " << a[i] << std::endl;
+
+	delete [] a;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+void run6_setup(
+		int max_threads,
+		int workload
+)
+{
+	std::cout << "RUN 6: setup" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	float s = 1.0;
+
+	for (int i = 0; i < 20; i++)
+	{
+		v1[i] = s;
+		s += 0.9+0.1*6.0/((double)((i+2)*(i+3)));
+	}
+
+	cPmo->invade(1, 1024, v1);
+}
+
+
+void run6_loop(
+		int max_threads,
+		int workload
+)
+{
+	std::cout << "RUN 6 (reinvade nonblocking)" << std::endl;
+
+	cPmo->reinvade_nonblocking();
+
+	int n = cPmo->getNumberOfThreads();
+	std::vector<double> a(n);
+
+	cPmo->parallel_for(
+			0, n, 1,
+			[&a, &workload](int i)
+			{
+				a[i] = CDummyWorkload::doSomeSqrt(918238123.0, workload);
+			}
+		);
+
+	for (int i = 0; i < n; i++)
+		std::cout << "RESULT (" << i << "): " << a[i] << std::endl;
+}
+
+
+void run6_shutdown(
+		int max_threads,
+		int workload
+)
+{
+	std::cout << "RUN 6: shutdown" << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * long running parallel loop with checkpoints between the chunks
+ */
+void run12(
+		int max_threads,
+		int workload,
+		int num_chunks
+)
+{
+	std::cout << "RUN 12 (chunked parallel loop with checkpoints)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	int chunk_size = cPmo->getMaxNumberOfThreads();
+
+	cPmo->parallel_for_chunked(
+			0, num_chunks*chunk_size, chunk_size,
+			[&workload](int i)
+			{
+				CDummyWorkload::doSomeSqrt(918238123.0, workload);
+			}
+		);
+
+	std::cout << "THREADS AFTER LOOP: " << cPmo->getNumberOfThreads() << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+/**
+ * benchmark: fixed number of work units of the dummy workload which are
+ * distributed among all threads while the resources are updated with
+ * nonblocking reinvades (see also test 40 of the OMP and TBB clients)
+ */
+void runBenchmark(
+		int max_threads,
+		int workload,
+		int iterations
+)
+{
+	std::cout << "RUN BENCHMARK (dummy workload)" << std::endl;
+
+	std::vector<float> v1(20, 0);
+	for (int i = 0; i < 20; i++)
+		v1[i] = i+1;
+
+	cPmo->invade(1, 1024, v1);
+
+	int work_units = 64;
+
+	CStopwatch stopwatch;
+	stopwatch.reset();
+	stopwatch.start();
+
+	for (int j = 0; j < iterations; j++)
+	{
+		cPmo->reinvade_nonblocking();
+
+		cPmo->parallel_for(
+				0, work_units, 1,
+				[&workload](int i)
+				{
+					CDummyWorkload::doSomeSqrt(918238123.0, workload);
+				}
+			);
+	}
+
+	stopwatch.stop();
+
+	std::cout << "BENCHMARK: " << stopwatch.time/(double)iterations << " seconds per iteration with " << cPmo->getNumberOfThreads() << " threads" << std::endl;
+
+	cPmo->client_shutdown_hint = workload;
+}
+
+
+
+
+/**
+ * micro-benchmark of the resize latency: alternate between a single thread
+ * and all threads, first with unchanged cpus (pin-skip cache) and then with
+ * rotated cpus. each resize is followed by an empty parallel region.
+ */
+void runResizeBenchmark(
+		int max_threads,
+		int iterations
+)
+{
+	std::cout << "RUN RESIZE BENCHMARK" << std::endl;
+
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+
+	std::vector<int> cpus;
+	for (int i = 0; i < CPU_SETSIZE; i++)
+		if (CPU_ISSET(i, &cpu_set))
+			cpus.push_back(i);
+
+	int n = cPmo->getMaxNumberOfThreads();
+
+	for (int rotate = 0; rotate < 2; rotate++)
+	{
+		CStopwatch stopwatch;
+		stopwatch.reset();
+
+		std::vector<int> affinities(n);
+
+		for (int j = 0; j < iterations; j++)
+		{
+			int num_threads = (j & 1 ? n : 1);
+
+			for (int i = 0; i < n; i++)
+				affinities[i] = cpus[(i + rotate*j) % cpus.size()];
+
+			stopwatch.start();
+
+			cPmo->setNumberOfThreads(num_threads);
+			cPmo->setAffinities(affinities.data(), num_threads);
+
+			cPmo->parallel_for(
+					0, num_threads, 1,
+					[](int i)
+					{
+					}
+				);
+
+			stopwatch.stop();
+		}
+
+		std::cout << "RESIZE LATENCY (" << (rotate ? "changed" : "unchanged") << " cpus): " << stopwatch.time*1000000.0/(double)iterations << " us" << std::endl;
+	}
+
+	cPmo->setNumberOfThreads(1);
+	cPmo->setAffinities(&cpus[0], 1);
+
+	cPmo->client_shutdown_hint = iterations;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	int max_threads = -1;
+	int test_program = 1;
+
+	if (argc > 1)
+	{
+		test_program = atoi(argv[1]);
+	}
+
+	cPmo = new CPMO_Threads(max_threads);
+	cPmo->setup();
+
+
+	switch(test_program)
+	{
+	case 1:
+		run1(max_threads);
+		break;
+
+	case 6:
+		run6_setup(max_threads, 40000);
+		run6_loop(max_threads, 40000);
+		run6_shutdown(max_threads, 40000);
+		break;
+
+	case 11:
+		while (true)
+			run1(max_threads, 4000);
+		break;
+
+	case 16:
+		run6_setup(max_threads, 4000);
+		while (true)
+			run6_loop(max_threads, 4000);
+		run6_shutdown(max_threads, 4000);
+		break;
+
+	case 21:
+		for (int i = 0; i < 100; i++)
+			run1(max_threads, 4000);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 26:
+		run6_setup(max_threads, 4000);
+
+		for (int i = 0; i < 100; i++)
+			run6_loop(max_threads, 4000);
+
+		run6_shutdown(max_threads, 4000);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 32:
+		run12(max_threads, 200, 1000);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 40:
+		runBenchmark(max_threads, 200, 100);
+		cPmo->client_shutdown_hint = 4000*20;
+		break;
+
+	case 41:
+		runResizeBenchmark(max_threads, 1000);
+		break;
+	}
+
+	cPmo->retreat();
+
+	delete cPmo;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,323 @@
+/*
+ * CMemoryMigration.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Migration of registered memory buffers of a client to the NUMA domains
+ * of its cores after the server moved the cores to other NUMA domains.
+ *
+ * Each buffer is split into as many blocks as the client has threads and
+ * the pages of the i-th block are moved to the NUMA domain of the i-th
+ * core. This matches the usual static partitioning of arrays among the
+ * threads (e.g. omp for schedule(static)).
+ *
+ * The pages are moved with move_pages(2) by a background thread in
+ * batches. The bandwidth of the migration is limited to keep the memory
+ * bandwidth available to the application. A new core assignment restarts
+ * the migration with the new target domains.
+ */
+
+#ifndef CMEMORYMIGRATION_HPP_
+#define CMEMORYMIGRATION_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+#include "CNumaTopology.hpp"
+#include "CStopwatch.hpp"
+
+
+#ifndef MPOL_MF_MOVE
+#	define MPOL_MF_MOVE	(1<<1)
+#endif
+
+
+
+class CMemoryMigration
+{
+	struct SBuffer
+	{
+		char *ptr;
+		size_t size;
+	};
+
+	CNumaTopology cNumaTopology;
+
+	/**
+	 * registered buffers
+	 */
+	std::vector<SBuffer> buffers;
+
+	/**
+	 * NUMA domain for each thread of the current core assignment
+	 */
+	std::vector<int> thread_nodes;
+
+	/**
+	 * incremented for each change of the NUMA domains, restarts the migration
+	 */
+	int generation;
+
+	/**
+	 * maximum migration bandwidth in bytes per second (<= 0: unlimited)
+	 */
+	double max_bytes_per_second;
+
+	/**
+	 * number of pages moved with a single move_pages call
+	 */
+	int pages_per_batch;
+
+	size_t page_size;
+
+	std::thread *migration_thread;
+	std::mutex migration_mutex;
+	std::condition_variable migration_condition;
+	bool migration_shutdown;
+
+	int verbose_level;
+
+public:
+	/**
+	 * statistics: number of pages which were placed on their target NUMA domain
+	 */
+	size_t moved_pages;
+
+
+
+private:
+	/**
+	 * move the pages of a buffer to the NUMA domains of the threads
+	 *
+	 * \return false if the migration was interrupted by a new core assignment or shutdown
+	 */
+	bool migrateBuffer(
+			const SBuffer &i_buffer,
+			const std::vector<int> &i_thread_nodes,
+			int i_generation
+	)
+	{
+		uintptr_t begin = ((uintptr_t)i_buffer.ptr + page_size-1) & ~(uintptr_t)(page_size-1);
+		uintptr_t end = ((uintptr_t)i_buffer.ptr + i_buffer.size) & ~(uintptr_t)(page_size-1);
+
+		if (end <= begin)
+			return true;
+
+		size_t num_pages = (end-begin)/page_size;
+		size_t num_threads = i_thread_nodes.size();
+
+		std::vector<void*> pages(pages_per_batch);
+		std::vector<int> nodes(pages_per_batch);
+		std::vector<int> status(pages_per_batch);
+
+		for (size_t p = 0; p < num_pages; p += pages_per_batch)
+		{
+			int n = std::min((size_t)pages_per_batch, num_pages-p);
+
+			for (int i = 0; i < n; i++)
+			{
+				pages[i] = (void*)(begin + (p+i)*page_size);
+				nodes[i] = i_thread_nodes[(p+i)*num_threads/num_pages];
+			}
+
+			double start = CStopwatch::getCurrentClockSeconds();
+
+			long retval = syscall(SYS_move_pages, 0, (unsigned long)n, pages.data(), nodes.data(), status.data(), MPOL_MF_MOVE);
+
+			if (retval < 0)
+			{
+				if (verbose_level > 1)
+					perror("move_pages");
+				return true;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(migration_mutex);
+
+				for (int i = 0; i < n; i++)
+					if (status[i] == nodes[i])
+						moved_pages++;
+			}
+
+			// rate limit
+			if (max_bytes_per_second > 0)
+			{
+				double seconds = (double)n*(double)page_size/max_bytes_per_second - (CStopwatch::getCurrentClockSeconds()-start);
+
+				if (seconds > 0)
+				{
+					std::unique_lock<std::mutex> lock(migration_mutex);
+					migration_condition.wait_for(lock, std::chrono::duration<double>(seconds));
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(migration_mutex);
+			if (migration_shutdown || generation != i_generation)
+				return false;
+		}
+
+		return true;
+	}
+
+
+
+	void migrationThreadLoop()
+	{
+		int done_generation = 0;
+
+		while (true)
+		{
+			std::vector<SBuffer> migrate_buffers;
+			std::vector<int> migrate_thread_nodes;
+			int migrate_generation;
+
+			{
+				std::unique_lock<std::mutex> lock(migration_mutex);
+
+				while (!migration_shutdown && generation == done_generation)
+					migration_condition.wait(lock);
+
+				if (migration_shutdown)
+					return;
+
+				migrate_buffers = buffers;
+				migrate_thread_nodes = thread_nodes;
+				migrate_generation = generation;
+			}
+
+			if (verbose_level > 3)
+				std::cout << "memory migration: moving " << migrate_buffers.size() << " buffers" << std::endl;
+
+			bool finished = true;
+			for (size_t i = 0; i < migrate_buffers.size() && finished; i++)
+				finished = migrateBuffer(migrate_buffers[i], migrate_thread_nodes, migrate_generation);
+
+			if (finished)
+				done_generation = migrate_generation;
+		}
+	}
+
+
+
+public:
+	CMemoryMigration(
+			double i_max_bytes_per_second,	///< maximum migration bandwidth (<= 0: unlimited)
+			int i_verbose_level = 0
+	)	:
+		generation(0),
+		max_bytes_per_second(i_max_bytes_per_second),
+		pages_per_batch(256),
+		migration_shutdown(false),
+		verbose_level(i_verbose_level),
+		moved_pages(0)
+	{
+		page_size = sysconf(_SC_PAGESIZE);
+
+		migration_thread = new std::thread(&CMemoryMigration::migrationThreadLoop, this);
+	}
+
+
+
+	~CMemoryMigration()
+	{
+		{
+			std::lock_guard<std::mutex> lock(migration_mutex);
+			migration_shutdown = true;
+		}
+		migration_condition.notify_all();
+
+		migration_thread->join();
+		delete migration_thread;
+	}
+
+
+
+	/**
+	 * register a buffer which is migrated with the cores of the client
+	 */
+	void registerBuffer(
+			void *i_ptr,
+			size_t i_size
+	)
+	{
+		std::lock_guard<std::mutex> lock(migration_mutex);
+
+		SBuffer b;
+		b.ptr = (char*)i_ptr;
+		b.size = i_size;
+		buffers.push_back(b);
+	}
+
+
+
+	/**
+	 * unregister a buffer before it is freed
+	 *
+	 * a running migration of this buffer stops after the current batch
+	 */
+	void unregisterBuffer(
+			void *i_ptr
+	)
+	{
+		std::lock_guard<std::mutex> lock(migration_mutex);
+
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			if (buffers[i].ptr != (char*)i_ptr)
+				continue;
+
+			buffers.erase(buffers.begin()+i);
+
+			// restart the migration without this buffer
+			generation++;
+			migration_condition.notify_all();
+			return;
+		}
+	}
+
+
+
+	/**
+	 * start the migration if the NUMA domains of the cores changed
+	 */
+	void updateAffinities(
+			const int *i_cpu_affinities,
+			int i_number_of_cpu_affinities
+	)
+	{
+		std::vector<int> nodes(i_number_of_cpu_affinities);
+		for (int i = 0; i < i_number_of_cpu_affinities; i++)
+			nodes[i] = cNumaTopology.getNode(i_cpu_affinities[i]);
+
+		std::lock_guard<std::mutex> lock(migration_mutex);
+
+		// the first assignment only records the domains of the first touch
+		if (thread_nodes.empty())
+		{
+			thread_nodes = nodes;
+			return;
+		}
+
+		if (nodes == thread_nodes)
+			return;
+
+		if (verbose_level > 3)
+			std::cout << "memory migration: NUMA domains of the cores changed" << std::endl;
+
+		thread_nodes = nodes;
+		generation++;
+		migration_condition.notify_all();
+	}
+};
+
+
+#endif /* CMEMORYMIGRATION_HPP_ */
@@ -102,12 +102,29 @@ public:
 
 
 
+protected:
+	/**
+	 * setup without a system message queue
+	 *
+	 * this is used by transports which deliver the messages in another way
+	 * (e.g. the virtual message queue of the simulator)
+	 */
+	CMessageQueueServer()	:
+		CMessageQueue()
+	{
+		key = -1;
+		msqid = -1;
+	}
+
+
+
+public:
 	/**
 	 * send a message packed into msg_data_load_ptr
 	 * \param i_length	length of message
 	 * \param i_mtype	type of message
 	 */
-	void sendToClient(
+	virtual void sendToClient(
 		size_t i_length,	///< length of message without mtype!
 		long int i_mtype
 	)
@@ -128,7 +145,7 @@ public:
 	 *
 	 * \param i_mtype	message type to receive
 	 */
-	int receiveFromClient(
+	virtual int receiveFromClient(
 			long i_mtype = 1
 	)
 	{
@@ -155,9 +172,10 @@ public:
 	 *
 	 * delete message queue
 	 */
-	~CMessageQueueServer()
+	virtual ~CMessageQueueServer()
 	{
-		msgctl(msqid, IPC_RMID, NULL);
+		if (msqid != -1)
+			msgctl(msqid, IPC_RMID, NULL);
 	}
 };
 
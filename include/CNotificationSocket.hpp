@@ -0,0 +1,177 @@
+/*
+ * CNotificationSocket.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Notification channel from the server to a client which is signaled
+ * whenever an asynchronous resource update was sent to the client.
+ *
+ * The client binds a datagram socket in the abstract unix socket namespace
+ * (no file is created) with a name derived from its pid. The file
+ * descriptor of this socket can be added to an existing epoll/poll/select
+ * loop of the application which is then woken up without polling the
+ * message queue.
+ *
+ * The server sends a single byte for each notification. Notifications to
+ * clients without a bound socket are dropped.
+ */
+
+#ifndef CNOTIFICATION_SOCKET_HPP
+#define CNOTIFICATION_SOCKET_HPP
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+
+
+class CNotificationSocket
+{
+	/**
+	 * socket file descriptor
+	 */
+	int fd;
+
+
+	/**
+	 * setup the abstract socket address of a client
+	 */
+	static socklen_t getAddress(
+			pid_t i_pid,
+			struct sockaddr_un *o_address
+	)
+	{
+		memset(o_address, 0, sizeof(*o_address));
+		o_address->sun_family = AF_UNIX;
+
+		// abstract namespace: the name starts with a null byte
+		int len = snprintf(o_address->sun_path+1, sizeof(o_address->sun_path)-1, "ipmo_notify_%d", (int)i_pid);
+
+		return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + len);
+	}
+
+
+public:
+	CNotificationSocket()	:
+		fd(-1)
+	{
+	}
+
+
+
+	~CNotificationSocket()
+	{
+		if (fd >= 0)
+			close(fd);
+	}
+
+
+
+	/**
+	 * return the file descriptor (-1 if not setup)
+	 */
+	int getFd()
+	{
+		return fd;
+	}
+
+
+
+	/**
+	 * client: bind the notification socket of the given pid
+	 *
+	 * \return false if the socket could not be setup
+	 */
+	bool setupReceiver(
+			pid_t i_pid
+	)
+	{
+		fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0)
+		{
+			perror("notification socket");
+			return false;
+		}
+
+		struct sockaddr_un address;
+		socklen_t len = getAddress(i_pid, &address);
+
+		if (bind(fd, (struct sockaddr*)&address, len) != 0)
+		{
+			perror("notification socket bind");
+			close(fd);
+			fd = -1;
+			return false;
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * client: consume all pending notifications
+	 *
+	 * \return number of pending notifications
+	 */
+	int drain()
+	{
+		if (fd < 0)
+			return 0;
+
+		int n = 0;
+		char buf[64];
+		while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+			n++;
+
+		return n;
+	}
+
+
+
+	/**
+	 * server: setup an unbound socket to send notifications
+	 */
+	bool setupSender()
+	{
+		fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0)
+		{
+			perror("notification socket");
+			return false;
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * server: notify a client
+	 *
+	 * notifications are dropped if the client did not bind its socket or
+	 * if its socket buffer is full (there are pending notifications anyway)
+	 */
+	void notify(
+			pid_t i_pid
+	)
+	{
+		if (fd < 0)
+			return;
+
+		struct sockaddr_un address;
+		socklen_t len = getAddress(i_pid, &address);
+
+		char c = 1;
+		sendto(fd, &c, 1, MSG_DONTWAIT, (struct sockaddr*)&address, len);
+	}
+};
+
+#endif
@@ -0,0 +1,323 @@
+/*
+ * CNumaArena.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * NUMA aware allocation of memory for the cores assigned to a client.
+ *
+ * Clients don't know in advance on which cores their threads are executed,
+ * hence the first touch placement of memory is accidental. The arena uses
+ * the current cores of the client (see CPMO::applyAffinities()) and sets
+ * the memory policy of newly mapped pages with mbind(2) before they are
+ * touched:
+ *
+ *  - local: the memory of a thread is preferred on the NUMA domain of
+ *    its core
+ *  - partitioned: a buffer is split into as many blocks as the client has
+ *    threads (page granularity) and each block is preferred on the NUMA
+ *    domain of its thread, matching static partitioning among the threads
+ *  - interleaved: the pages of shared data are interleaved among the NUMA
+ *    domains of all cores
+ *
+ * mbind is called through syscall() to avoid a dependency on libnuma. If
+ * the policy can't be set (e.g. for a domain of a simulated topology, see
+ * CNumaTopology), the default first touch placement is used. The planned
+ * domains are stored for each allocation (see getBlockNodes()).
+ */
+
+#ifndef CNUMAARENA_HPP_
+#define CNUMAARENA_HPP_
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <iostream>
+#include <cassert>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "CNumaTopology.hpp"
+
+
+#ifndef MPOL_PREFERRED
+#	define MPOL_PREFERRED	1
+#endif
+
+#ifndef MPOL_INTERLEAVE
+#	define MPOL_INTERLEAVE	3
+#endif
+
+
+
+class CNumaArena
+{
+	struct SAllocation
+	{
+		size_t size;
+
+		/**
+		 * planned NUMA domain of each block (-1: interleaved)
+		 */
+		std::vector<int> block_nodes;
+	};
+
+	CNumaTopology cNumaTopology;
+
+	/**
+	 * allocations by their address
+	 */
+	std::map<void*, SAllocation> allocations;
+
+	std::mutex allocations_mutex;
+
+	size_t page_size;
+
+	int verbose_level;
+
+
+
+	/**
+	 * set the memory policy of a page aligned range
+	 *
+	 * \return false if the policy could not be set
+	 */
+	bool bind(
+			char *i_ptr,
+			size_t i_size,
+			int i_mode,
+			const std::vector<int> &i_nodes
+	)
+	{
+		if (i_size == 0)
+			return true;
+
+		unsigned long nodemask[16] = {0};
+		unsigned long maxnode = sizeof(nodemask)*8;
+
+		for (size_t i = 0; i < i_nodes.size(); i++)
+		{
+			if (i_nodes[i] < 0 || i_nodes[i] >= (int)maxnode)
+				return false;
+
+			nodemask[i_nodes[i]/(sizeof(unsigned long)*8)] |= 1UL << (i_nodes[i] % (sizeof(unsigned long)*8));
+		}
+
+		if (syscall(SYS_mbind, i_ptr, i_size, i_mode, nodemask, maxnode, 0) != 0)
+		{
+			if (verbose_level > 1)
+				perror("mbind");
+			return false;
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * map new pages
+	 */
+	char *map(
+			size_t i_size
+	)
+	{
+		void *ptr = mmap(nullptr, i_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (ptr == MAP_FAILED)
+		{
+			perror("mmap");
+			return nullptr;
+		}
+
+		return (char*)ptr;
+	}
+
+
+
+	void *record(
+			char *i_ptr,
+			size_t i_size,
+			const std::vector<int> &i_block_nodes
+	)
+	{
+		std::lock_guard<std::mutex> lock(allocations_mutex);
+
+		SAllocation &a = allocations[i_ptr];
+		a.size = i_size;
+		a.block_nodes = i_block_nodes;
+
+		return i_ptr;
+	}
+
+
+
+public:
+	CNumaArena(
+			int i_verbose_level = 0
+	)	:
+		verbose_level(i_verbose_level)
+	{
+		page_size = sysconf(_SC_PAGESIZE);
+	}
+
+
+
+	~CNumaArena()
+	{
+		for (std::map<void*, SAllocation>::iterator i = allocations.begin(); i != allocations.end(); i++)
+			munmap(i->first, i->second.size);
+	}
+
+
+
+	/**
+	 * return the NUMA domain of a cpu
+	 */
+	int getNode(
+			int i_cpu_id
+	)	const
+	{
+		return cNumaTopology.getNode(i_cpu_id);
+	}
+
+
+
+	/**
+	 * allocate memory of a single thread on the NUMA domain of its core
+	 */
+	void *allocateLocal(
+			size_t i_size,
+			int i_cpu_id		///< core of the thread
+	)
+	{
+		size_t size = (i_size + page_size-1) & ~(page_size-1);
+
+		char *ptr = map(size);
+		if (ptr == nullptr)
+			return nullptr;
+
+		std::vector<int> nodes(1, cNumaTopology.getNode(i_cpu_id));
+		bind(ptr, size, MPOL_PREFERRED, nodes);
+
+		return record(ptr, size, nodes);
+	}
+
+
+
+	/**
+	 * allocate a buffer which is partitioned statically among the threads
+	 *
+	 * the i-th block of the buffer is preferred on the NUMA domain of the
+	 * i-th core. the blocks are rounded to pages.
+	 */
+	void *allocatePartitioned(
+			size_t i_size,
+			const int *i_cpu_affinities,
+			int i_number_of_cpu_affinities
+	)
+	{
+		assert(i_number_of_cpu_affinities > 0);
+
+		size_t size = (i_size + page_size-1) & ~(page_size-1);
+
+		char *ptr = map(size);
+		if (ptr == nullptr)
+			return nullptr;
+
+		size_t num_pages = size/page_size;
+		std::vector<int> block_nodes(i_number_of_cpu_affinities);
+
+		for (int i = 0; i < i_number_of_cpu_affinities; i++)
+		{
+			size_t start = num_pages*i/i_number_of_cpu_affinities;
+			size_t end = num_pages*(i+1)/i_number_of_cpu_affinities;
+
+			block_nodes[i] = cNumaTopology.getNode(i_cpu_affinities[i]);
+
+			std::vector<int> nodes(1, block_nodes[i]);
+			bind(ptr+start*page_size, (end-start)*page_size, MPOL_PREFERRED, nodes);
+		}
+
+		return record(ptr, size, block_nodes);
+	}
+
+
+
+	/**
+	 * allocate shared data which is interleaved among the NUMA domains of all cores
+	 */
+	void *allocateInterleaved(
+			size_t i_size,
+			const int *i_cpu_affinities,
+			int i_number_of_cpu_affinities
+	)
+	{
+		size_t size = (i_size + page_size-1) & ~(page_size-1);
+
+		char *ptr = map(size);
+		if (ptr == nullptr)
+			return nullptr;
+
+		std::vector<int> nodes;
+		for (int i = 0; i < i_number_of_cpu_affinities; i++)
+		{
+			int node = cNumaTopology.getNode(i_cpu_affinities[i]);
+			if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+				nodes.push_back(node);
+		}
+
+		if (nodes.size() > 1)
+			bind(ptr, size, MPOL_INTERLEAVE, nodes);
+
+		return record(ptr, size, std::vector<int>(1, -1));
+	}
+
+
+
+	/**
+	 * free memory of the arena
+	 */
+	void free(
+			void *i_ptr
+	)
+	{
+		std::lock_guard<std::mutex> lock(allocations_mutex);
+
+		std::map<void*, SAllocation>::iterator i = allocations.find(i_ptr);
+		if (i == allocations.end())
+		{
+			std::cerr << "CNumaArena: free of unknown pointer " << i_ptr << std::endl;
+			return;
+		}
+
+		munmap(i->first, i->second.size);
+		allocations.erase(i);
+	}
+
+
+
+	/**
+	 * return the planned NUMA domains of the blocks of an allocation
+	 * (-1 for interleaved allocations)
+	 */
+	std::vector<int> getBlockNodes(
+			void *i_ptr
+	)
+	{
+		std::lock_guard<std::mutex> lock(allocations_mutex);
+
+		std::map<void*, SAllocation>::iterator i = allocations.find(i_ptr);
+		if (i == allocations.end())
+			return std::vector<int>();
+
+		return i->second.block_nodes;
+	}
+};
+
+
+#endif /* CNUMAARENA_HPP_ */
@@ -0,0 +1,275 @@
+/*
+ * CNumaTopology.hpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CNUMATOPOLOGY_HPP_
+#define CNUMATOPOLOGY_HPP_
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+/**
+ * NUMA topology of the system
+ *
+ * the topology is read from sysfs. if this information is not available,
+ * all cpus are associated to a single NUMA domain 0.
+ *
+ * a topology can be simulated with the environment variable
+ * IPMO_NUMA_TOPOLOGY which lists the cpus of each NUMA domain separated
+ * by ';', e.g. IPMO_NUMA_TOPOLOGY="0-1;2-3" for two domains.
+ */
+class CNumaTopology
+{
+public:
+	/**
+	 * NUMA domain for each cpu id
+	 */
+	std::vector<int> cpu_to_node;
+
+	/**
+	 * number of NUMA domains
+	 */
+	int num_nodes;
+
+
+
+	CNumaTopology(
+			const char *i_sysfs_node_path = "/sys/devices/system/node"	///< path to NUMA node information
+	)	:
+		num_nodes(1)
+	{
+		const char *simulated_topology = getenv("IPMO_NUMA_TOPOLOGY");
+
+		if (simulated_topology != nullptr)
+			setupSimulated(simulated_topology);
+		else
+			setup(i_sysfs_node_path);
+	}
+
+
+
+	/**
+	 * parse a list of cpus in the kernel format (e.g. "0-3,8,10-11")
+	 */
+	static void parseCpuList(
+			const std::string &i_cpu_list,	///< cpu list
+			std::vector<int> &o_cpus		///< output: cpu ids
+	)
+	{
+		o_cpus.clear();
+
+		std::stringstream ss(i_cpu_list);
+		std::string range;
+
+		while (std::getline(ss, range, ','))
+		{
+			if (range.empty() || range[0] == '\n')
+				continue;
+
+			int start, end;
+			size_t p = range.find('-');
+
+			if (p == std::string::npos)
+			{
+				start = atoi(range.c_str());
+				end = start;
+			}
+			else
+			{
+				start = atoi(range.substr(0, p).c_str());
+				end = atoi(range.substr(p+1).c_str());
+			}
+
+			for (int i = start; i <= end; i++)
+				o_cpus.push_back(i);
+		}
+	}
+
+
+
+	/**
+	 * read first line of a file
+	 *
+	 * \return false if file is not available
+	 */
+	static bool readFirstLine(
+			const std::string &i_filename,
+			std::string &o_line
+	)
+	{
+		std::ifstream f(i_filename.c_str());
+
+		if (!f.is_open())
+			return false;
+
+		std::getline(f, o_line);
+		return true;
+	}
+
+
+
+	/**
+	 * read the effective cpuset of the cgroup (v2) of this process
+	 *
+	 * \return false if this information is not available
+	 */
+	static bool readCgroupCpus(
+			std::vector<int> &o_cpu_ids		///< output: cpu ids
+	)
+	{
+		// cgroup v2: /proc/self/cgroup contains a single line "0::[path]"
+		std::string cgroup;
+		if (!readFirstLine("/proc/self/cgroup", cgroup) || cgroup.compare(0, 3, "0::") != 0)
+			return false;
+
+		std::string cpu_list;
+		if (!readFirstLine("/sys/fs/cgroup"+cgroup.substr(3)+"/cpuset.cpus.effective", cpu_list) || cpu_list.empty())
+			return false;
+
+		parseCpuList(cpu_list, o_cpu_ids);
+		return !o_cpu_ids.empty();
+	}
+
+
+
+	/**
+	 * return the SMT siblings of a cpu (including the cpu itself)
+	 *
+	 * if this information is not available, only the cpu itself is returned
+	 */
+	static void getSMTSiblings(
+			int i_cpu_id,
+			std::vector<int> &o_cpus,	///< output: cpu ids
+			const char *i_sysfs_cpu_path = "/sys/devices/system/cpu"	///< path to cpu information
+	)
+	{
+		std::ostringstream filename;
+		filename << i_sysfs_cpu_path << "/cpu" << i_cpu_id << "/topology/thread_siblings_list";
+
+		std::string cpu_list;
+		if (readFirstLine(filename.str(), cpu_list))
+			parseCpuList(cpu_list, o_cpus);
+		else
+			o_cpus.clear();
+
+		if (std::find(o_cpus.begin(), o_cpus.end(), i_cpu_id) == o_cpus.end())
+			o_cpus.push_back(i_cpu_id);
+	}
+
+
+
+	/**
+	 * setup topology from sysfs
+	 */
+	void setup(
+			const char *i_sysfs_node_path
+	)
+	{
+		cpu_to_node.clear();
+		num_nodes = 1;
+
+		DIR *dir = opendir(i_sysfs_node_path);
+		if (dir == nullptr)
+			return;
+
+		int max_node = 0;
+
+		struct dirent *e;
+		while ((e = readdir(dir)) != nullptr)
+		{
+			if (strncmp(e->d_name, "node", 4) != 0)
+				continue;
+
+			if (e->d_name[4] < '0' || e->d_name[4] > '9')
+				continue;
+
+			int node = atoi(e->d_name+4);
+
+			std::string cpu_list;
+			if (!readFirstLine(std::string(i_sysfs_node_path)+"/"+e->d_name+"/cpulist", cpu_list))
+				continue;
+
+			std::vector<int> cpus;
+			parseCpuList(cpu_list, cpus);
+
+			for (size_t i = 0; i < cpus.size(); i++)
+			{
+				if (cpus[i] >= (int)cpu_to_node.size())
+					cpu_to_node.resize(cpus[i]+1, 0);
+
+				cpu_to_node[cpus[i]] = node;
+			}
+
+			max_node = std::max(max_node, node);
+		}
+
+		closedir(dir);
+
+		num_nodes = max_node+1;
+	}
+
+
+
+	/**
+	 * setup simulated topology with the cpu lists of the NUMA domains
+	 * separated by ';' (e.g. "0-1;2-3")
+	 */
+	void setupSimulated(
+			const std::string &i_node_cpu_lists
+	)
+	{
+		cpu_to_node.clear();
+		num_nodes = 0;
+
+		std::stringstream ss(i_node_cpu_lists);
+		std::string cpu_list;
+
+		while (std::getline(ss, cpu_list, ';'))
+		{
+			std::vector<int> cpus;
+			parseCpuList(cpu_list, cpus);
+
+			for (size_t i = 0; i < cpus.size(); i++)
+			{
+				if (cpus[i] >= (int)cpu_to_node.size())
+					cpu_to_node.resize(cpus[i]+1, 0);
+
+				cpu_to_node[cpus[i]] = num_nodes;
+			}
+
+			num_nodes++;
+		}
+
+		if (num_nodes == 0)
+			num_nodes = 1;
+	}
+
+
+
+	/**
+	 * return NUMA domain of cpu
+	 */
+	int getNode(
+			int i_cpu_id
+	)	const
+	{
+		if (i_cpu_id < 0 || i_cpu_id >= (int)cpu_to_node.size())
+			return 0;
+
+		return cpu_to_node[i_cpu_id];
+	}
+};
+
+
+#endif /* CNUMATOPOLOGY_HPP_ */
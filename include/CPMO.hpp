@@ -14,9 +14,72 @@
 #include <sched.h>
 #include <vector>
 #include <signal.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <errno.h>
 
 #include "../include/CMessageQueueClient.hpp"
 #include "../include/SPMOMessage.hpp"
+#include "../include/CScalabilityProfiler.hpp"
+#include "../include/CStopwatch.hpp"
+#include "../include/CNotificationSocket.hpp"
+#include "../include/CMemoryMigration.hpp"
+#include "../include/CNumaArena.hpp"
+#include "../include/CNumaTopology.hpp"
+
+
+
+class CPMO;
+
+
+
+/**
+ * handle of an asynchronous request (see CPMO::invade_async())
+ *
+ * the answer is received by the progress thread of the client. the
+ * resources are updated when the request is completed with get() by the
+ * thread which executes the parallel regions.
+ */
+class CPMOFuture
+{
+	CPMO *cPmo;
+
+public:
+	CPMOFuture(
+			CPMO *i_cPmo
+	)	:
+		cPmo(i_cPmo)
+	{
+	}
+
+	/**
+	 * return true if the answer was received
+	 */
+	bool ready();
+
+	/**
+	 * wait until the answer was received
+	 */
+	void wait();
+
+	/**
+	 * wait at most the given number of seconds, return true if the answer was received
+	 */
+	bool wait_for(double i_seconds);
+
+	/**
+	 * wait for the answer and update the resources
+	 *
+	 * return true if the resources were changed
+	 */
+	bool get();
+};
 
 
 
@@ -25,6 +88,8 @@
  */
 class CPMO
 {
+	friend class CPMOFuture;
+
 public:
 	/**
 	 * number of threads available in whole system
@@ -69,6 +134,100 @@ private:
 	 */
 	bool retreat_in_progress;
 
+	/**
+	 * progress thread receiving the messages from the server (nullptr if not started)
+	 */
+	std::thread *progress_thread;
+
+	/**
+	 * progress thread: messages received from the server which were not processed so far
+	 */
+	std::deque<std::vector<char> > progress_messages;
+
+	std::mutex progress_mutex;
+	std::condition_variable progress_condition;
+
+	/**
+	 * an asynchronous request is pending, answer type and true if the answer was received
+	 */
+	bool async_request_pending;
+	unsigned long long async_answer_type;
+	bool async_answer_received;
+
+	/**
+	 * the answer of the pending asynchronous request was already processed
+	 * (e.g. by reinvade_nonblocking() or lend()) and whether it changed the resources
+	 */
+	bool async_answer_consumed;
+	bool async_answer_resources_changed;
+
+	/**
+	 * notification socket which is signaled by the server for each asynchronous resource update
+	 */
+	CNotificationSocket *cNotificationSocket;
+
+	/**
+	 * set by the progress thread if a resource update was received (see checkpoint())
+	 */
+	std::atomic<bool> checkpoint_update_pending;
+
+	/**
+	 * checkpoint() without progress thread: minimum time between two polls of the message queue
+	 */
+	double checkpoint_poll_interval;
+	double checkpoint_last_poll_time;
+
+	/**
+	 * affinities of the currently used cores
+	 */
+	std::vector<int> current_affinities;
+
+	/**
+	 * lending is active (see lend())
+	 */
+	bool lending_active;
+
+	/**
+	 * affinities before lending which are restored by lend_end()
+	 */
+	std::vector<int> lend_affinities;
+
+	/**
+	 * idle detection: thread lending the cores if no parallel phase was running
+	 * for the idle threshold (nullptr if not started, see setupIdleDetection())
+	 */
+	std::thread *idle_detector_thread;
+
+	std::mutex idle_mutex;
+	std::condition_variable idle_condition;
+	bool idle_detector_shutdown;
+
+	double idle_threshold;				///< seconds without parallel phase before the cores are lent
+	int idle_parallel_phase_depth;		///< number of running parallel phases
+	double idle_since_timestamp;		///< end of the last parallel phase
+	bool idle_lending_active;			///< cores were lent by the idle detection
+
+	/**
+	 * number of cores currently used by this client
+	 */
+	std::atomic<int> idle_number_of_cores;
+
+	/**
+	 * separate message buffer for the lend messages of the idle detection
+	 */
+	CMessageQueueClient *idle_message_queue;
+
+	/**
+	 * migration of registered buffers after the cores were moved to other
+	 * NUMA domains (nullptr if not activated, see setupMemoryMigration())
+	 */
+	CMemoryMigration *cMemoryMigration;
+
+	/**
+	 * NUMA aware allocation for the current cores (created on first use)
+	 */
+	CNumaArena *cNumaArena;
+
 	/**
 	 * singleton for ctrl-c handler
 	 */
@@ -85,6 +244,57 @@ private:
 	unsigned long last_seq_id;
 
 
+	/**
+	 * position in the admission queue of the server (-1: not queued)
+	 */
+	int invade_queue_position;
+
+	/**
+	 * return from blocking invades if the client was queued (see setupInvadeQueueBackoff())
+	 */
+	bool invade_queue_backoff;
+
+	/**
+	 * priority class forwarded with each invade
+	 */
+	int priority_class;
+
+	/**
+	 * weight of the scalability forwarded with each invade
+	 */
+	float priority_weight;
+
+
+	/**
+	 * online scalability learning: profiler (nullptr if deactivated)
+	 */
+	CScalabilityProfiler *cScalabilityProfiler;
+
+	/**
+	 * online scalability learning: constraints and hints forwarded to the server
+	 */
+	int learning_min_cpus;
+	int learning_max_cpus;
+	float learning_distribution_hint;
+
+	/**
+	 * online scalability learning: send an update each n timesteps
+	 */
+	int learning_update_interval;
+	int learning_timesteps_since_update;
+
+	/**
+	 * online scalability learning: state at the beginning of the timestep
+	 */
+	double learning_timestep_start_time;
+	int learning_timestep_num_threads;
+
+	/**
+	 * online scalability learning: last scalability graph sent to the server
+	 */
+	std::vector<float> learning_last_scalability_graph;
+
+
 	/**
 	 * CTRL-C handler
 	 */
@@ -108,6 +318,41 @@ private:
 
 
 
+public:
+	/**
+	 * pin a thread to a single cpu
+	 *
+	 * \return false if the thread does not exist anymore
+	 */
+	static bool pinThread(
+			pid_t i_tid,		///< thread id (0: calling thread)
+			int i_cpu
+	)
+	{
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		CPU_SET(i_cpu, &cpu_set);
+
+		if (sched_setaffinity(i_tid, sizeof(cpu_set_t), &cpu_set) == 0)
+			return true;
+
+		if (errno == ESRCH)
+			return false;
+
+		/*
+		 * the cpu is not in the cpuset of the cgroup (enforced by the server),
+		 * e.g. the cores were lent. The kernel keeps the thread on the cpuset
+		 * until the cpu is assigned again with the next resource update.
+		 */
+		if (errno == EINVAL)
+			return true;
+
+		perror("sched_setaffinity");
+		assert(false);
+		exit(-1);
+	}
+
+
 private:
 	/**
 	 * shrink/grow number of threads to use for parallel regions
@@ -139,6 +384,23 @@ private:
 	) = 0;
 
 
+	/**
+	 * update the number of threads and their affinities
+	 */
+	void applyAffinities(
+			const int *i_cpu_affinities,
+			int i_number_of_cpu_affinities
+	)
+	{
+		setNumberOfThreads(i_number_of_cpu_affinities);
+		setAffinities(i_cpu_affinities, i_number_of_cpu_affinities);
+
+		current_affinities.assign(i_cpu_affinities, i_cpu_affinities+i_number_of_cpu_affinities);
+		idle_number_of_cores.store(i_number_of_cpu_affinities, std::memory_order_relaxed);
+	}
+
+
+
 	/**
 	 * handle invade message from server and return true if anything has to be changed
 	 */
@@ -157,12 +419,11 @@ private:
 		assert(sPMOMessage->data.invade_answer.number_of_cores > 0);
 
 //		std::cout << "HANDLE INVADE ANSWER: setNumberOfThreads" << std::endl;
-		// update number of threads
-		setNumberOfThreads(sPMOMessage->data.invade_answer.number_of_cores);
+		// update number of threads and affinities
+		applyAffinities(sPMOMessage->data.invade_answer.affinity_array, sPMOMessage->data.invade_answer.number_of_cores);
 
-		// update the affinities
-//		std::cout << "HANDLE INVADE ANSWER: setAffinities" << std::endl;
-		setAffinities(sPMOMessage->data.invade_answer.affinity_array, sPMOMessage->data.invade_answer.number_of_cores);
+		if (cMemoryMigration != nullptr)
+			cMemoryMigration->updateAffinities(sPMOMessage->data.invade_answer.affinity_array, sPMOMessage->data.invade_answer.number_of_cores);
 
 //		std::cout << "HANDLE INVADE ANSWER: END" << std::endl;
 		return true;
@@ -182,11 +443,11 @@ private:
 
 		assert(sPMOMessage->data.invade_answer.number_of_cores > 0);
 
-		// update number of threads
-		setNumberOfThreads(sPMOMessage->data.invade_answer.number_of_cores);
+		// update number of threads and affinities
+		applyAffinities(sPMOMessage->data.invade_answer.affinity_array, sPMOMessage->data.invade_answer.number_of_cores);
 
-		// update the affinities
-		setAffinities(sPMOMessage->data.invade_answer.affinity_array, sPMOMessage->data.invade_answer.number_of_cores);
+		if (cMemoryMigration != nullptr)
+			cMemoryMigration->updateAffinities(sPMOMessage->data.invade_answer.affinity_array, sPMOMessage->data.invade_answer.number_of_cores);
 
 		// send update to server
 		sPMOMessage->package_type = SPMOMessage::CLIENT_REINVADE_ACK_NONBLOCKING;
@@ -218,8 +479,41 @@ public:
 		client_shutdown_hint(0),
 		shutdown_in_progress(false),
 		retreat_in_progress(false),
+		progress_thread(nullptr),
+		async_request_pending(false),
+		async_answer_type(SPMOMessage::DUMMY),
+		async_answer_received(false),
+		async_answer_consumed(false),
+		async_answer_resources_changed(false),
+		cNotificationSocket(nullptr),
+		checkpoint_update_pending(false),
+		checkpoint_poll_interval(0.001),
+		checkpoint_last_poll_time(-1),
+		lending_active(false),
+		idle_detector_thread(nullptr),
+		idle_detector_shutdown(false),
+		idle_threshold(0),
+		idle_parallel_phase_depth(0),
+		idle_since_timestamp(0),
+		idle_lending_active(false),
+		idle_number_of_cores(0),
+		idle_message_queue(nullptr),
+		cMemoryMigration(nullptr),
+		cNumaArena(nullptr),
 		verbose_level(i_verbose_level),
 		last_seq_id(0),
+		invade_queue_position(-1),
+		invade_queue_backoff(false),
+		priority_class(0),
+		priority_weight(1.0f),
+		cScalabilityProfiler(nullptr),
+		learning_min_cpus(1),
+		learning_max_cpus(1),
+		learning_distribution_hint(-1.0f),
+		learning_update_interval(1),
+		learning_timesteps_since_update(0),
+		learning_timestep_start_time(-1),
+		learning_timestep_num_threads(0),
 		wait_for_ack(i_wait_for_ack)
 #if DEBUG
 		,
@@ -247,6 +541,10 @@ public:
 		sPMOMessage->data.client_setup.pid = this_pid;
 		sPMOMessage->data.client_setup.seq_id = last_seq_id;
 
+		// coupled clients (e.g. the ranks of an MPI job) share a group id
+		const char *group_id = getenv("IPMO_GROUP_ID");
+		sPMOMessage->data.client_setup.group_id = (group_id != nullptr ? atoi(group_id) : 0);
+
 		// send message to server
 		cMessageQueue->sendToServer(
 				(size_t)&(sPMOMessage->data.client_setup) - (size_t)sPMOMessage +
@@ -292,6 +590,11 @@ public:
 #endif
 
 		shutdown();
+
+		delete cScalabilityProfiler;
+		delete cNotificationSocket;
+		delete cMemoryMigration;
+		delete cNumaArena;
 	}
 
 
@@ -311,6 +614,8 @@ public:
 	    signal(SIGTERM, SIG_DFL);
 		signal(SIGINT, SIG_DFL);
 
+		stopIdleDetection();
+
 		// send setup message
 		sPMOMessage->package_type = SPMOMessage::CLIENT_SHUTDOWN;
 		sPMOMessage->data.client_shutdown.pid = this_pid;
@@ -324,6 +629,14 @@ public:
 		// WAIT FOR ACK
 		msg_recv_message_loop_blocking(SPMOMessage::CLIENT_ACK_SHUTDOWN);
 
+		// the progress thread finishes after receiving the ack
+		if (progress_thread != nullptr)
+		{
+			progress_thread->join();
+			delete progress_thread;
+			progress_thread = nullptr;
+		}
+
 		if (cMessageQueue != nullptr)
 		{
 			delete cMessageQueue;
@@ -340,12 +653,17 @@ private:
 			int i_scalability_graph_size,		///< size of scalability graph
 			const float *i_scalability_graph,	///< scalability graph
 			float i_distribution_hint,			///< distribution hint
-			SPMOMessage::MSG_TYPE i_package_type = SPMOMessage::CLIENT_INVADE
+			SPMOMessage::MSG_TYPE i_package_type = SPMOMessage::CLIENT_INVADE,
+			float i_remaining_work = -1.0f,		///< remaining work in seconds on a single core
+			float i_deadline = -1.0f			///< seconds until the remaining work should be finished
 	)
 	{
 		assert(i_min_cpus > 0);
 		assert(i_max_cpus > 0);
 
+		// the server ends lending with a new invade, the cores are assigned with the answer
+		lending_active = false;
+
 		sPMOMessage->package_type = i_package_type;
 
 		// PID
@@ -358,6 +676,14 @@ private:
 		// DISTRIBUTION HINT
 		sPMOMessage->data.invade.distribution_hint = i_distribution_hint;
 
+		// PRIORITY
+		sPMOMessage->data.invade.priority_class = priority_class;
+		sPMOMessage->data.invade.weight = priority_weight;
+
+		// DEADLINE
+		sPMOMessage->data.invade.remaining_work = i_remaining_work;
+		sPMOMessage->data.invade.deadline = i_deadline;
+
 		// SCALABILITY GRAPH
 		sPMOMessage->data.invade.scalability_graph_size = i_scalability_graph_size;
 		for (int i = 0; i < i_scalability_graph_size; i++)
@@ -374,11 +700,35 @@ private:
 
 
 	/**
-	 * handle message
+	 * handle message and remember if it answered the pending asynchronous request
 	 *
 	 * return true if the resources were changed
 	 */
 	bool msg_recv_message_innerloop()
+	{
+		// the message buffer may be reused to send an ack
+		unsigned long long package_type = sPMOMessage->package_type;
+
+		bool resources_changed = msg_recv_message_process();
+
+		if (async_request_pending && package_type == async_answer_type)
+		{
+			std::lock_guard<std::mutex> lock(progress_mutex);
+			async_answer_consumed = true;
+			async_answer_resources_changed = resources_changed;
+		}
+
+		return resources_changed;
+	}
+
+
+
+	/**
+	 * handle message
+	 *
+	 * return true if the resources were changed
+	 */
+	bool msg_recv_message_process()
 	{
 		switch(sPMOMessage->package_type)
 		{
@@ -409,8 +759,24 @@ private:
 				assert(sPMOMessage->data.invade_answer.seq_id > last_seq_id);
 				last_seq_id = sPMOMessage->data.invade_answer.seq_id;
 
+				invade_queue_position = -1;
+
 				return handleInvadeAnswer();
 
+			case SPMOMessage::SERVER_INVADE_QUEUED:
+				if (sPMOMessage->data.invade_queued.seq_id <= last_seq_id)
+					std::cerr << "SEQ ID wrong " << sPMOMessage->data.invade_queued.seq_id << " <= " << last_seq_id << std::endl;
+
+				assert(sPMOMessage->data.invade_queued.seq_id > last_seq_id);
+				last_seq_id = sPMOMessage->data.invade_queued.seq_id;
+
+				invade_queue_position = sPMOMessage->data.invade_queued.position;
+
+				if (verbose_level > 3)
+					std::cout << this_pid << ": INVADE QUEUED AT POSITION " << invade_queue_position << " OF " << sPMOMessage->data.invade_queued.queue_length << std::endl;
+
+				return false;
+
 			case SPMOMessage::SERVER_REINVADE_NONBLOCKING:
 //				std::cout << this_pid << ": Processing message type SERVER_REINVADE_NONBLOCKING" << std::endl;
 				if (sPMOMessage->data.invade.seq_id <= last_seq_id)
@@ -447,120 +813,392 @@ private:
 
 
 
-	bool msg_recv_message_loop_blocking(
-			unsigned long long stop_message = SPMOMessage::DUMMY
+	/**
+	 * receive the next message from the server
+	 *
+	 * if the progress thread is running, the message is taken from the
+	 * messages received by this thread.
+	 *
+	 * return -1 if no message is available in nonblocking mode
+	 */
+	int receiveFromServer(
+			bool i_blocking		///< wait for a message
 	)
 	{
-		while (cMessageQueue->receiveFromServer(this_pid) >= 0)
+		if (progress_thread == nullptr)
 		{
-//			std::cout << "WAIT FOR MSG" << std::endl;
-			bool resources_changed = msg_recv_message_innerloop();
-
-//			std::cout << "MSG RECEIVED and PROCESSED" << std::endl;
-
-			if (sPMOMessage->package_type == stop_message)
-				return resources_changed;
-
-			if (stop_message == SPMOMessage::DUMMY)
-				return resources_changed;
+			if (i_blocking)
+				return cMessageQueue->receiveFromServer(this_pid);
+			else
+				return cMessageQueue->receiveNonblockingFromServer(this_pid);
 		}
 
-//		std::cout << "msg_recv_message_loop_blocking FIN" << std::endl;
-		return false;
-	}
-
-
+		std::unique_lock<std::mutex> lock(progress_mutex);
 
-	bool msg_recv_message_loop_nonblocking(
-			unsigned long long stop_message = SPMOMessage::DUMMY
-	)
-	{
-		while (cMessageQueue->receiveNonblockingFromServer(this_pid) >= 0)
+		if (progress_messages.empty())
 		{
-			bool resources_changed = msg_recv_message_innerloop();
-
-			if (sPMOMessage->package_type == stop_message)
-				return resources_changed;
+			if (!i_blocking)
+				return -1;
 
-			if (stop_message == SPMOMessage::DUMMY)
-				return resources_changed;
+			while (progress_messages.empty())
+				progress_condition.wait(lock);
 		}
 
-		return false;
+		std::vector<char> &msg = progress_messages.front();
+		memcpy(cMessageQueue->msg_data_load_ptr, msg.data(), msg.size());
+		int len = msg.size();
+
+		progress_messages.pop_front();
+
+		return len;
 	}
 
 
 
-public:
 	/**
-	 * invade computation resources
+	 * progress thread: receive all messages from the server until the shutdown ack
 	 */
-	bool invade_blocking(
-			int i_min_cpus,								///< minimum number of cores
-			int i_max_cpus,								///< maximum number of cores
-			int i_scalability_graph_size = 0,			///< size of scalability graph
-			const float *i_scalability_graph = nullptr,	///< scalability graph
-			float i_distribution_hint = -1.0f			///< distribution hint
-	)
+	void progressThreadLoop()
 	{
-//		std::cout << this_pid << ": invade_blocking START" << std::endl;
+		// separate message buffer for receiving
+		CMessageQueueClient cMessageQueueReceive(verbose_level);
+		SPMOMessage *m = (SPMOMessage*)cMessageQueueReceive.msg_data_load_ptr;
 
 		/*
-		 * TODO: probably another handling is necessary to assure that all
+		 * the notification of the server can arrive before the resource update
+		 * was queued by this thread and handleNotification() would miss the
+		 * update => notify again once the update was queued
 		 */
-		retreat_in_progress = false;
+		CNotificationSocket cNotificationSender;
+		cNotificationSender.setupSender();
 
-		msg_send_invade(
-				i_min_cpus,
-				i_max_cpus,
-				i_scalability_graph_size,
-				i_scalability_graph,
-				i_distribution_hint
-			);
+		while (true)
+		{
+			int len = cMessageQueueReceive.receiveFromServer(this_pid);
 
-		bool retval = msg_recv_message_loop_blocking(SPMOMessage::SERVER_INVADE_ANSWER);
+			{
+				std::lock_guard<std::mutex> lock(progress_mutex);
 
-//		std::cout << "invade_blocking END" << std::endl;
-		return retval;
+				const char *data = (const char*)cMessageQueueReceive.msg_data_load_ptr;
+				progress_messages.push_back(std::vector<char>(data, data+len));
+
+				if (async_request_pending && m->package_type == async_answer_type)
+					async_answer_received = true;
+			}
+
+			if (m->package_type == SPMOMessage::SERVER_REINVADE_NONBLOCKING)
+			{
+				checkpoint_update_pending.store(true, std::memory_order_release);
+				cNotificationSender.notify(this_pid);
+			}
+
+			progress_condition.notify_all();
+
+			if (m->package_type == SPMOMessage::CLIENT_ACK_SHUTDOWN || m->package_type == SPMOMessage::SERVER_QUIT)
+				return;
+		}
 	}
 
 
 
-public:
 	/**
-	 * invade computation resources (nonblocking)
+	 * idle detection: send a lend or lend end message with the separate message buffer
+	 *
+	 * the idle mutex has to be locked
 	 */
-	void invade_nonblocking(
-			int i_min_cpus,		///< minimum number of cores
-			int i_max_cpus,		///< maximum number of cores
-			int i_scalability_graph_size = 0,				///< size of scalability graph
-			const float *i_scalability_graph = nullptr,	///< scalability graph
-			float i_distribution_hint = -1.0f				///< distribution hint
+	void idleSendLendMessage(
+			unsigned long long i_package_type
 	)
 	{
-		assert(setup_executed);
+		SPMOMessage *m = (SPMOMessage*)idle_message_queue->msg_data_load_ptr;
 
-		msg_send_invade(
-				i_min_cpus,
-				i_max_cpus,
-				i_scalability_graph_size,
-				i_scalability_graph,
-				i_distribution_hint,
-				SPMOMessage::CLIENT_INVADE_NONBLOCKING
-			);
+		m->package_type = i_package_type;
+		m->data.lend.pid = this_pid;
+
+		idle_message_queue->sendToServer(
+									(size_t)&(m->data) - (size_t)m +
+									sizeof(m->data.lend)
+								);
 	}
 
 
 
 	/**
-	 * invade with scalability graph
-	 *
-	 * this also means an implicit retreat
+	 * idle detection: lend the cores if no parallel phase was running for the idle threshold
 	 */
-public:
-	bool invade(
-			int i_min_cpus,
-			int i_max_cpus,
+	void idleDetectorLoop()
+	{
+		std::unique_lock<std::mutex> lock(idle_mutex);
+
+		std::chrono::duration<double> poll_interval(std::max(idle_threshold*0.25, 0.001));
+
+		while (true)
+		{
+			idle_condition.wait_for(lock, poll_interval);
+
+			if (idle_detector_shutdown)
+				return;
+
+			if (idle_parallel_phase_depth > 0 || idle_lending_active)
+				continue;
+
+			if (CStopwatch::getCurrentClockSeconds() - idle_since_timestamp < idle_threshold)
+				continue;
+
+			if (idle_number_of_cores.load(std::memory_order_relaxed) <= 1)
+				continue;
+
+			if (verbose_level > 3)
+				std::cout << this_pid << ": IDLE, LENDING CORES" << std::endl;
+
+			// the idle threads keep their affinities, the cores are reclaimed by the next parallel phase
+			idle_lending_active = true;
+			idleSendLendMessage(SPMOMessage::CLIENT_LEND);
+		}
+	}
+
+
+
+	void stopIdleDetection()
+	{
+		if (idle_detector_thread == nullptr)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(idle_mutex);
+			idle_detector_shutdown = true;
+		}
+		idle_condition.notify_all();
+
+		idle_detector_thread->join();
+		delete idle_detector_thread;
+		idle_detector_thread = nullptr;
+
+		delete idle_message_queue;
+		idle_message_queue = nullptr;
+	}
+
+
+
+	/**
+	 * setup an asynchronous request before sending it and start the progress thread if required
+	 *
+	 * \return false if another asynchronous request is still pending => the request must not be sent
+	 */
+	bool beginAsyncRequest(
+			unsigned long long i_answer_type	///< message type which completes the request
+	)
+	{
+		startProgressThread();
+
+		std::lock_guard<std::mutex> lock(progress_mutex);
+
+		if (async_request_pending)
+		{
+			std::cerr << this_pid << ": asynchronous request already pending => new request not sent" << std::endl;
+			return false;
+		}
+
+		async_request_pending = true;
+		async_answer_type = i_answer_type;
+		async_answer_received = false;
+		async_answer_consumed = false;
+		async_answer_resources_changed = false;
+
+		return true;
+	}
+
+
+
+	bool msg_recv_message_loop_blocking(
+			unsigned long long stop_message = SPMOMessage::DUMMY
+	)
+	{
+		while (receiveFromServer(true) >= 0)
+		{
+//			std::cout << "WAIT FOR MSG" << std::endl;
+			bool resources_changed = msg_recv_message_innerloop();
+
+//			std::cout << "MSG RECEIVED and PROCESSED" << std::endl;
+
+			if (sPMOMessage->package_type == stop_message)
+				return resources_changed;
+
+			if (stop_message == SPMOMessage::DUMMY)
+				return resources_changed;
+
+			// the invade answer is processed by one of the next (re)invades
+			if (	sPMOMessage->package_type == SPMOMessage::SERVER_INVADE_QUEUED &&
+					stop_message == SPMOMessage::SERVER_INVADE_ANSWER &&
+					invade_queue_backoff
+			)
+				return false;
+		}
+
+//		std::cout << "msg_recv_message_loop_blocking FIN" << std::endl;
+		return false;
+	}
+
+
+
+	bool msg_recv_message_loop_nonblocking(
+			unsigned long long stop_message = SPMOMessage::DUMMY
+	)
+	{
+		while (receiveFromServer(false) >= 0)
+		{
+			bool resources_changed = msg_recv_message_innerloop();
+
+			if (sPMOMessage->package_type == stop_message)
+				return resources_changed;
+
+			if (stop_message == SPMOMessage::DUMMY)
+				return resources_changed;
+		}
+
+		return false;
+	}
+
+
+
+public:
+	/**
+	 * invade computation resources
+	 */
+	bool invade_blocking(
+			int i_min_cpus,								///< minimum number of cores
+			int i_max_cpus,								///< maximum number of cores
+			int i_scalability_graph_size = 0,			///< size of scalability graph
+			const float *i_scalability_graph = nullptr,	///< scalability graph
+			float i_distribution_hint = -1.0f			///< distribution hint
+	)
+	{
+//		std::cout << this_pid << ": invade_blocking START" << std::endl;
+
+		/*
+		 * TODO: probably another handling is necessary to assure that all
+		 */
+		retreat_in_progress = false;
+
+		msg_send_invade(
+				i_min_cpus,
+				i_max_cpus,
+				i_scalability_graph_size,
+				i_scalability_graph,
+				i_distribution_hint
+			);
+
+		bool retval = msg_recv_message_loop_blocking(SPMOMessage::SERVER_INVADE_ANSWER);
+
+//		std::cout << "invade_blocking END" << std::endl;
+		return retval;
+	}
+
+
+
+public:
+	/**
+	 * invade computation resources (nonblocking)
+	 */
+	void invade_nonblocking(
+			int i_min_cpus,		///< minimum number of cores
+			int i_max_cpus,		///< maximum number of cores
+			int i_scalability_graph_size = 0,				///< size of scalability graph
+			const float *i_scalability_graph = nullptr,	///< scalability graph
+			float i_distribution_hint = -1.0f				///< distribution hint
+	)
+	{
+		assert(setup_executed);
+
+		msg_send_invade(
+				i_min_cpus,
+				i_max_cpus,
+				i_scalability_graph_size,
+				i_scalability_graph,
+				i_distribution_hint,
+				SPMOMessage::CLIENT_INVADE_NONBLOCKING
+			);
+	}
+
+
+
+	/**
+	 * invade computation resources to finish the remaining work by a deadline
+	 *
+	 * the server assigns the cores to equalize the predicted finish times
+	 * (remaining work divided by the scalability) of all clients with a
+	 * deadline. e.g. ranks of a coupled simulation then reach the next
+	 * barrier at the same time. with a deadline which can be met, only the
+	 * cores required to finish by the deadline are assigned.
+	 */
+	bool invade_deadline_blocking(
+			int i_min_cpus,								///< minimum number of cores
+			int i_max_cpus,								///< maximum number of cores
+			float i_remaining_work,						///< remaining work in seconds on a single core
+			float i_deadline = -1.0f,					///< seconds until the work should be finished (<= 0: as early as possible)
+			int i_scalability_graph_size = 0,			///< size of scalability graph
+			const float *i_scalability_graph = nullptr	///< scalability graph
+	)
+	{
+		assert(setup_executed);
+		assert(i_remaining_work > 0);
+
+		retreat_in_progress = false;
+
+		msg_send_invade(
+				i_min_cpus,
+				i_max_cpus,
+				i_scalability_graph_size,
+				i_scalability_graph,
+				-1.0f,
+				SPMOMessage::CLIENT_INVADE,
+				i_remaining_work,
+				i_deadline
+			);
+
+		return msg_recv_message_loop_blocking(SPMOMessage::SERVER_INVADE_ANSWER);
+	}
+
+
+
+	/**
+	 * invade computation resources to finish the remaining work by a deadline (nonblocking)
+	 */
+	void invade_deadline_nonblocking(
+			int i_min_cpus,								///< minimum number of cores
+			int i_max_cpus,								///< maximum number of cores
+			float i_remaining_work,						///< remaining work in seconds on a single core
+			float i_deadline = -1.0f,					///< seconds until the work should be finished (<= 0: as early as possible)
+			int i_scalability_graph_size = 0,			///< size of scalability graph
+			const float *i_scalability_graph = nullptr	///< scalability graph
+	)
+	{
+		assert(setup_executed);
+		assert(i_remaining_work > 0);
+
+		msg_send_invade(
+				i_min_cpus,
+				i_max_cpus,
+				i_scalability_graph_size,
+				i_scalability_graph,
+				-1.0f,
+				SPMOMessage::CLIENT_INVADE_NONBLOCKING,
+				i_remaining_work,
+				i_deadline
+			);
+	}
+
+
+
+	/**
+	 * invade with scalability graph
+	 *
+	 * this also means an implicit retreat
+	 */
+public:
+	bool invade(
+			int i_min_cpus,
+			int i_max_cpus,
 			std::vector<float> &scalability_graph
 	)
 	{
@@ -637,31 +1275,745 @@ public:
 
 
 	/**
-	 * retreat all resources
+	 * setup the minimum time between two polls of the message queue in checkpoint()
+	 *
+	 * only used if the progress thread is not running
 	 */
-	void retreat(bool dontWaitForAck = false)
+	void setupCheckpoint(
+			double i_poll_interval	///< seconds, 0 to poll during each checkpoint
+	)
 	{
-		assert(setup_executed);
+		checkpoint_poll_interval = i_poll_interval;
+	}
 
-		retreat_in_progress = true;
 
-		sPMOMessage->package_type = SPMOMessage::CLIENT_RETREAT;
-		sPMOMessage->data.retreat.pid = this_pid;
 
-		// send setup message
-		cMessageQueue->sendToServer(
-									(size_t)&(sPMOMessage->data) - (size_t)sPMOMessage +
-									sizeof(sPMOMessage->data.retreat)
-								);
+	/**
+	 * cooperative preemption point
+	 *
+	 * can be called frequently by the thread running the client outside of
+	 * parallel regions, e.g. between the chunks of a parallel loop (see
+	 * parallel_for_chunked() of the backends). a resource update sent by the
+	 * server is applied immediately, hence released cores are vacated without
+	 * waiting for the next reinvade_nonblocking().
+	 *
+	 * with the progress thread running, only an atomic flag is tested.
+	 * otherwise, the message queue is polled at most once per poll interval.
+	 *
+	 * \return true if the resources were changed
+	 */
+	bool checkpoint()
+	{
+		if (progress_thread != nullptr)
+		{
+			if (!checkpoint_update_pending.load(std::memory_order_acquire))
+				return false;
 
-		if (dontWaitForAck)
+			checkpoint_update_pending.store(false, std::memory_order_relaxed);
+
+			bool resources_changed = false;
+			while (reinvade_nonblocking())
+				resources_changed = true;
+
+			// further updates which were received in the meantime
+			std::lock_guard<std::mutex> lock(progress_mutex);
+			if (!progress_messages.empty())
+				checkpoint_update_pending.store(true, std::memory_order_relaxed);
+
+			return resources_changed;
+		}
+
+		double t = CStopwatch::getCurrentClockSeconds();
+		if (t - checkpoint_last_poll_time < checkpoint_poll_interval)
+			return false;
+
+		checkpoint_last_poll_time = t;
+
+		return reinvade_nonblocking();
+	}
+
+
+
+	/**
+	 * start the idle detection
+	 *
+	 * if no parallel phase (see parallelPhaseBegin()) was running for the
+	 * given threshold, e.g. during a serial phase of the application, all
+	 * cores except the first one are lent to other clients. the next parallel
+	 * phase continues immediately on the previous cores, the server
+	 * guarantees this number of cores to the client and requests the
+	 * borrowing clients to release the cores.
+	 */
+	void setupIdleDetection(
+			double i_idle_threshold		///< seconds without parallel phase before the cores are lent
+	)
+	{
+		assert(setup_executed);
+
+		if (idle_detector_thread != nullptr)
 			return;
 
-		msg_recv_message_loop_blocking(SPMOMessage::SERVER_ACK);
+		idle_threshold = i_idle_threshold;
+		idle_since_timestamp = CStopwatch::getCurrentClockSeconds();
+		idle_detector_shutdown = false;
+
+		idle_message_queue = new CMessageQueueClient(verbose_level);
+		idle_detector_thread = new std::thread(&CPMO::idleDetectorLoop, this);
 	}
-};
 
 
-CPMO *CPMO::cPmoSingleton = 0;
+
+	/**
+	 * start of a parallel phase, called by the backends
+	 *
+	 * cores which were lent by the idle detection are reclaimed
+	 */
+	void parallelPhaseBegin()
+	{
+		if (idle_detector_thread == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(idle_mutex);
+
+		idle_parallel_phase_depth++;
+
+		if (!idle_lending_active)
+			return;
+
+		if (verbose_level > 3)
+			std::cout << this_pid << ": PARALLEL PHASE, RECLAIMING LENT CORES" << std::endl;
+
+		idle_lending_active = false;
+		idleSendLendMessage(SPMOMessage::CLIENT_LEND_END);
+	}
+
+
+
+	/**
+	 * end of a parallel phase, called by the backends
+	 */
+	void parallelPhaseEnd()
+	{
+		if (idle_detector_thread == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(idle_mutex);
+
+		idle_parallel_phase_depth--;
+
+		if (idle_parallel_phase_depth == 0)
+			idle_since_timestamp = CStopwatch::getCurrentClockSeconds();
+	}
+
+
+
+	/**
+	 * activate the migration of registered buffers
+	 *
+	 * if the server moves the cores of this client to other NUMA domains,
+	 * the pages of the registered buffers are moved to the new domains in the
+	 * background. the current cores are assumed to be the ones which first
+	 * touched the buffers.
+	 */
+	void setupMemoryMigration(
+			double i_max_bytes_per_second = 1024.0*1024.0*1024.0	///< maximum migration bandwidth (<= 0: unlimited)
+	)
+	{
+		assert(setup_executed);
+
+		if (cMemoryMigration != nullptr)
+			return;
+
+		cMemoryMigration = new CMemoryMigration(i_max_bytes_per_second, verbose_level);
+
+		if (!current_affinities.empty())
+			cMemoryMigration->updateAffinities(current_affinities.data(), current_affinities.size());
+	}
+
+
+
+	/**
+	 * register a large buffer which is partitioned statically among the threads
+	 */
+	void registerMemoryBuffer(
+			void *i_ptr,
+			size_t i_size
+	)
+	{
+		if (cMemoryMigration != nullptr)
+			cMemoryMigration->registerBuffer(i_ptr, i_size);
+	}
+
+
+
+	/**
+	 * unregister a buffer before it is freed
+	 */
+	void unregisterMemoryBuffer(
+			void *i_ptr
+	)
+	{
+		if (cMemoryMigration != nullptr)
+			cMemoryMigration->unregisterBuffer(i_ptr);
+	}
+
+
+
+	/**
+	 * return the NUMA arena for the current cores
+	 */
+	CNumaArena *getNumaArena()
+	{
+		if (cNumaArena == nullptr)
+			cNumaArena = new CNumaArena(verbose_level);
+
+		return cNumaArena;
+	}
+
+
+
+	/**
+	 * allocate memory of a thread on the NUMA domain of its current core
+	 *
+	 * the allocation functions have to be called outside of parallel regions
+	 */
+	void *numaAllocateLocal(
+			size_t i_size,
+			int i_thread_id
+	)
+	{
+		assert(i_thread_id >= 0 && i_thread_id < (int)current_affinities.size());
+
+		return getNumaArena()->allocateLocal(i_size, current_affinities[i_thread_id]);
+	}
+
+
+
+	/**
+	 * allocate a buffer whose i-th block is placed on the NUMA domain of the
+	 * i-th thread (static partitioning among the current threads)
+	 */
+	void *numaAllocatePartitioned(
+			size_t i_size
+	)
+	{
+		assert(!current_affinities.empty());
+
+		return getNumaArena()->allocatePartitioned(i_size, current_affinities.data(), current_affinities.size());
+	}
+
+
+
+	/**
+	 * allocate shared data interleaved among the NUMA domains of the current cores
+	 */
+	void *numaAllocateInterleaved(
+			size_t i_size
+	)
+	{
+		assert(!current_affinities.empty());
+
+		return getNumaArena()->allocateInterleaved(i_size, current_affinities.data(), current_affinities.size());
+	}
+
+
+
+	/**
+	 * free memory allocated with one of the numaAllocate functions
+	 */
+	void numaFree(
+			void *i_ptr
+	)
+	{
+		getNumaArena()->free(i_ptr);
+	}
+
+
+
+	/**
+	 * return from blocking invades if no core is free
+	 *
+	 * the server queues clients without a core and answers their invade once
+	 * cores were released. with backoff, blocking invades return immediately
+	 * after the client was queued (see getInvadeQueuePosition()) and the
+	 * answer is processed by one of the next invades or nonblocking reinvades.
+	 */
+	void setupInvadeQueueBackoff(
+			bool i_backoff = true
+	)
+	{
+		invade_queue_backoff = i_backoff;
+	}
+
+
+
+	/**
+	 * return the position in the admission queue of the server (-1: not queued)
+	 */
+	int getInvadeQueuePosition()
+	{
+		return invade_queue_position;
+	}
+
+
+
+	/**
+	 * setup priority class and weight which are forwarded with all following invades
+	 *
+	 * clients in higher priority classes are always preferred during the resource
+	 * distribution and their minimum number of cores is guaranteed first.
+	 * within a priority class, the scalability is weighted with the given weight.
+	 */
+	void setPriority(
+			int i_priority_class,		///< priority class (0: default, higher values are preferred)
+			float i_weight = 1.0f		///< weight within priority class
+	)
+	{
+		assert(i_priority_class >= 0);
+		assert(i_weight > 0);
+
+		priority_class = i_priority_class;
+		priority_weight = i_weight;
+	}
+
+
+
+	/**
+	 * activate online learning of the scalability graph
+	 *
+	 * the throughput has to be reported with timestep_begin() / timestep_end().
+	 * updated scalability graphs are then automatically forwarded to the
+	 * server with invade_nonblocking.
+	 */
+	void scalability_learning_setup(
+			int i_min_cpus,						///< minimum number of cores
+			int i_max_cpus,						///< maximum number of cores
+			int i_update_interval = 10,			///< send updated scalability graph each n timesteps
+			float i_distribution_hint = -1.0f	///< distribution hint
+	)
+	{
+		assert(setup_executed);
+		assert(i_update_interval > 0);
+
+		learning_min_cpus = i_min_cpus;
+		learning_max_cpus = i_max_cpus;
+		learning_distribution_hint = i_distribution_hint;
+		learning_update_interval = i_update_interval;
+		learning_timesteps_since_update = 0;
+		learning_last_scalability_graph.clear();
+
+		delete cScalabilityProfiler;
+		cScalabilityProfiler = new CScalabilityProfiler(std::min(max_threads, i_max_cpus));
+	}
+
+
+
+	/**
+	 * start measuring the throughput of a timestep
+	 */
+	void timestep_begin()
+	{
+		if (cScalabilityProfiler == nullptr)
+			return;
+
+		learning_timestep_num_threads = num_computing_threads;
+		learning_timestep_start_time = CStopwatch::getCurrentClockSeconds();
+	}
+
+
+
+	/**
+	 * stop measuring the throughput of a timestep and forward
+	 * an updated scalability graph to the server if required
+	 */
+	void timestep_end(
+			double i_work_units		///< number of work units processed since timestep_begin()
+	)
+	{
+		if (cScalabilityProfiler == nullptr)
+			return;
+
+		if (learning_timestep_start_time < 0)
+			return;
+
+		double seconds = CStopwatch::getCurrentClockSeconds() - learning_timestep_start_time;
+		learning_timestep_start_time = -1;
+
+		// resources changed during the timestep => sample not meaningful
+		if (learning_timestep_num_threads != num_computing_threads)
+			return;
+
+		cScalabilityProfiler->addSample(learning_timestep_num_threads, i_work_units, seconds);
+
+		learning_timesteps_since_update++;
+		if (learning_timesteps_since_update < learning_update_interval)
+			return;
+
+		learning_timesteps_since_update = 0;
+
+		std::vector<float> scalability_graph;
+		cScalabilityProfiler->computeScalabilityGraph(scalability_graph);
+
+		if (scalability_graph.empty())
+			return;
+
+		/*
+		 * only send an update if the scalability graph changed by more than 1%
+		 */
+		if (learning_last_scalability_graph.size() == scalability_graph.size())
+		{
+			bool changed = false;
+			for (size_t i = 0; i < scalability_graph.size(); i++)
+			{
+				if (std::abs(scalability_graph[i] - learning_last_scalability_graph[i]) > 0.01f*std::abs(learning_last_scalability_graph[i]))
+				{
+					changed = true;
+					break;
+				}
+			}
+
+			if (!changed)
+				return;
+		}
+
+		learning_last_scalability_graph = scalability_graph;
+
+		if (verbose_level > 3)
+		{
+			std::cout << this_pid << ": LEARNED SCALABILITY GRAPH: ";
+			for (size_t i = 0; i < scalability_graph.size(); i++)
+				std::cout << scalability_graph[i] << " ";
+			std::cout << std::endl;
+		}
+
+		invade_nonblocking(
+				learning_min_cpus,
+				learning_max_cpus,
+				scalability_graph.size(),
+				scalability_graph.data(),
+				learning_distribution_hint
+			);
+	}
+
+
+
+	/**
+	 * setup the notification socket and return its file descriptor
+	 *
+	 * the file descriptor becomes readable whenever the server sent an
+	 * asynchronous resource update. it can be added to an epoll/poll loop
+	 * of the application which then calls handleNotification().
+	 * with a running progress thread, the descriptor is signaled again
+	 * once the update was received by the progress thread.
+	 *
+	 * \return -1 if the socket could not be setup
+	 */
+	int setupNotification()
+	{
+		if (cNotificationSocket == nullptr)
+		{
+			cNotificationSocket = new CNotificationSocket;
+
+			if (!cNotificationSocket->setupReceiver(this_pid))
+			{
+				delete cNotificationSocket;
+				cNotificationSocket = nullptr;
+				return -1;
+			}
+		}
+
+		return cNotificationSocket->getFd();
+	}
+
+
+
+	/**
+	 * consume the notifications and apply all pending resource updates
+	 *
+	 * \return true if the resources were changed
+	 */
+	bool handleNotification()
+	{
+		assert(setup_executed);
+
+		if (cNotificationSocket != nullptr)
+			cNotificationSocket->drain();
+
+		bool resources_changed = false;
+
+		// process all messages which were sent before the notifications
+		while (receiveFromServer(false) >= 0)
+		{
+			if (msg_recv_message_innerloop())
+				resources_changed = true;
+		}
+
+		return resources_changed;
+	}
+
+
+
+	/**
+	 * start the progress thread which receives the messages from the server
+	 *
+	 * this is done by the first asynchronous request (invade_async(),
+	 * reinvade_async(), retreat_async()). the resources are still only
+	 * updated by the thread which calls the CPMO methods.
+	 */
+	void startProgressThread()
+	{
+		if (progress_thread != nullptr)
+			return;
+
+		progress_thread = new std::thread(&CPMO::progressThreadLoop, this);
+	}
+
+
+
+	/**
+	 * invade computation resources without waiting for the answer
+	 *
+	 * the request is completed with CPMOFuture::get() which updates the resources.
+	 * only a single asynchronous request can be pending. otherwise, an error is
+	 * reported, the request is not sent and the returned future refers to the
+	 * pending request.
+	 */
+	CPMOFuture invade_async(
+			int i_min_cpus,								///< minimum number of cores
+			int i_max_cpus,								///< maximum number of cores
+			int i_scalability_graph_size = 0,			///< size of scalability graph
+			const float *i_scalability_graph = nullptr,	///< scalability graph
+			float i_distribution_hint = -1.0f			///< distribution hint
+	)
+	{
+		assert(setup_executed);
+
+		if (!beginAsyncRequest(SPMOMessage::SERVER_INVADE_ANSWER))
+			return CPMOFuture(this);
+
+		retreat_in_progress = false;
+
+		msg_send_invade(
+				i_min_cpus,
+				i_max_cpus,
+				i_scalability_graph_size,
+				i_scalability_graph,
+				i_distribution_hint
+			);
+
+		return CPMOFuture(this);
+	}
+
+
+
+	/**
+	 * reinvade without waiting for the answer (see invade_async())
+	 */
+	CPMOFuture reinvade_async()
+	{
+		assert(setup_executed);
+
+		if (!beginAsyncRequest(SPMOMessage::SERVER_INVADE_ANSWER))
+			return CPMOFuture(this);
+
+		sPMOMessage->package_type = SPMOMessage::CLIENT_REINVADE;
+		sPMOMessage->data.invade.pid = this_pid;
+
+		cMessageQueue->sendToServer(
+									(size_t)&(sPMOMessage->data) - (size_t)sPMOMessage +
+									sizeof(sPMOMessage->data.invade.pid)
+								);
+
+		return CPMOFuture(this);
+	}
+
+
+
+	/**
+	 * retreat all resources without waiting for the ack (see invade_async())
+	 */
+	CPMOFuture retreat_async()
+	{
+		assert(setup_executed);
+
+		if (!beginAsyncRequest(SPMOMessage::SERVER_ACK))
+			return CPMOFuture(this);
+
+		retreat(true);
+
+		return CPMOFuture(this);
+	}
+
+
+
+	/**
+	 * temporarily lend all cores except the first one to the server
+	 *
+	 * this is intended to be called before waiting in a blocking
+	 * synchronization (e.g. MPI_Barrier, see CPMO_PMPI.hpp). the client
+	 * immediately continues with a single thread on its first core and
+	 * the server assigns the lent cores to other clients until lend_end().
+	 *
+	 * the server refuses lending if an asynchronous resource update for
+	 * this client is still pending. the client then only runs with a
+	 * single thread until lend_end().
+	 *
+	 * has to be called outside of parallel regions.
+	 */
+	void lend()
+	{
+		assert(setup_executed);
+
+		if (lending_active || retreat_in_progress || shutdown_in_progress)
+			return;
+
+		// process a pending resource update before lending
+		reinvade_nonblocking();
+
+		if (current_affinities.size() <= 1)
+			return;
+
+		lend_affinities = current_affinities;
+		lending_active = true;
+
+		setNumberOfThreads(1);
+		setAffinities(lend_affinities.data(), 1);
+
+		sPMOMessage->package_type = SPMOMessage::CLIENT_LEND;
+		sPMOMessage->data.lend.pid = this_pid;
+
+		cMessageQueue->sendToServer(
+									(size_t)&(sPMOMessage->data) - (size_t)sPMOMessage +
+									sizeof(sPMOMessage->data.lend)
+								);
+	}
+
+
+
+	/**
+	 * end lending and continue with the cores used before lend()
+	 *
+	 * no answer from the server is awaited. the lent cores are used
+	 * immediately and shared with the clients which borrowed them until
+	 * the server requested these clients to release them. the cores are
+	 * then assigned to this client again with an asynchronous resource
+	 * update (see reinvade_nonblocking()).
+	 */
+	void lend_end()
+	{
+		assert(setup_executed);
+
+		if (!lending_active)
+			return;
+
+		lending_active = false;
+
+		sPMOMessage->package_type = SPMOMessage::CLIENT_LEND_END;
+		sPMOMessage->data.lend.pid = this_pid;
+
+		cMessageQueue->sendToServer(
+									(size_t)&(sPMOMessage->data) - (size_t)sPMOMessage +
+									sizeof(sPMOMessage->data.lend)
+								);
+
+		/*
+		 * if the server enforces the core distribution with cgroup cpusets,
+		 * only the first core is left in the cpuset while lending. The other
+		 * cores are used again once the server granted them.
+		 */
+		std::vector<int> cgroup_cpu_ids;
+		if (CNumaTopology::readCgroupCpus(cgroup_cpu_ids))
+		{
+			std::vector<int> affinities(1, lend_affinities[0]);
+
+			for (size_t i = 1; i < lend_affinities.size(); i++)
+				if (std::find(cgroup_cpu_ids.begin(), cgroup_cpu_ids.end(), lend_affinities[i]) != cgroup_cpu_ids.end())
+					affinities.push_back(lend_affinities[i]);
+
+			lend_affinities.swap(affinities);
+		}
+
+		applyAffinities(lend_affinities.data(), lend_affinities.size());
+	}
+
+
+
+	/**
+	 * retreat all resources
+	 */
+	void retreat(bool dontWaitForAck = false)
+	{
+		assert(setup_executed);
+
+		retreat_in_progress = true;
+		lending_active = false;
+
+		sPMOMessage->package_type = SPMOMessage::CLIENT_RETREAT;
+		sPMOMessage->data.retreat.pid = this_pid;
+
+		// send setup message
+		cMessageQueue->sendToServer(
+									(size_t)&(sPMOMessage->data) - (size_t)sPMOMessage +
+									sizeof(sPMOMessage->data.retreat)
+								);
+
+		if (dontWaitForAck)
+			return;
+
+		msg_recv_message_loop_blocking(SPMOMessage::SERVER_ACK);
+	}
+};
+
+
+CPMO *CPMO::cPmoSingleton = 0;
+
+
+
+inline bool CPMOFuture::ready()
+{
+	std::lock_guard<std::mutex> lock(cPmo->progress_mutex);
+	return cPmo->async_answer_received;
+}
+
+
+
+inline void CPMOFuture::wait()
+{
+	std::unique_lock<std::mutex> lock(cPmo->progress_mutex);
+	while (!cPmo->async_answer_received)
+		cPmo->progress_condition.wait(lock);
+}
+
+
+
+inline bool CPMOFuture::wait_for(double i_seconds)
+{
+	std::unique_lock<std::mutex> lock(cPmo->progress_mutex);
+
+	std::chrono::steady_clock::time_point timeout =
+			std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(i_seconds*1000000.0));
+
+	while (!cPmo->async_answer_received)
+		if (cPmo->progress_condition.wait_until(lock, timeout) == std::cv_status::timeout)
+			break;
+
+	return cPmo->async_answer_received;
+}
+
+
+
+inline bool CPMOFuture::get()
+{
+	assert(cPmo->async_request_pending);
+
+	// the answer was already processed while draining the messages
+	if (!cPmo->async_answer_consumed)
+		cPmo->msg_recv_message_loop_blocking(cPmo->async_answer_type);
+
+	std::lock_guard<std::mutex> lock(cPmo->progress_mutex);
+	cPmo->async_request_pending = false;
+
+	return cPmo->async_answer_resources_changed;
+}
 
 #endif /* CPMO_HPP_ */
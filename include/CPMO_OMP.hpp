@@ -17,10 +17,241 @@
 #include <signal.h>
 #include <unistd.h>
 #include <linux/unistd.h>
+#include <sys/syscall.h>
 
 #include "CPMO.hpp"
 
 
+/*
+ * pin the threads lazily with the OMP tools interface (OMPT) if the
+ * header is available. the OMP runtime has to support OMPT to activate
+ * the tool (e.g. LLVM/Intel OpenMP), otherwise the threads are pinned in
+ * an additional parallel region.
+ */
+#ifndef CPMO_OMP_OMPT
+#	if defined(__has_include)
+#		if __has_include(<omp-tools.h>)
+#			define CPMO_OMP_OMPT	1
+#		endif
+#	endif
+#endif
+
+#ifndef CPMO_OMP_OMPT
+#	define CPMO_OMP_OMPT	0
+#endif
+
+#if CPMO_OMP_OMPT
+#	include <omp-tools.h>
+#endif
+
+
+
+/**
+ * state shared with the OMPT callbacks
+ */
+struct SPMOOmptState
+{
+	/**
+	 * true if the tool was started by the OMP runtime
+	 */
+	bool active;
+
+	/**
+	 * cpu of each thread of top-level parallel regions
+	 */
+	std::vector<int> affinities;
+
+	/**
+	 * incremented for each update of the affinities
+	 */
+	int affinity_generation;
+
+	/**
+	 * number of threads requested within a parallel region (-1: nothing requested)
+	 */
+	int pending_num_threads;
+
+	/**
+	 * client which is informed about the begin and end of top-level parallel regions (idle detection)
+	 */
+	CPMO *cPmo;
+
+
+	SPMOOmptState()	:
+		active(false),
+		affinity_generation(0),
+		pending_num_threads(-1),
+		cPmo(nullptr)
+	{
+	}
+
+
+	static SPMOOmptState &get()
+	{
+		static SPMOOmptState s;
+		return s;
+	}
+};
+
+
+
+#if CPMO_OMP_OMPT
+
+#define CPMO_OMPT_INITIAL_TASK		1
+#define CPMO_OMPT_TOPLEVEL_REGION	2
+
+
+/**
+ * mark top-level parallel regions (encountered by the initial task)
+ */
+static void cpmo_ompt_parallel_begin(
+		ompt_data_t *encountering_task_data,
+		const ompt_frame_t *encountering_task_frame,
+		ompt_data_t *parallel_data,
+		unsigned int requested_parallelism,
+		int flags,
+		const void *codeptr_ra
+)
+{
+	if (encountering_task_data == nullptr || encountering_task_data->value != CPMO_OMPT_INITIAL_TASK)
+	{
+		parallel_data->value = 0;
+		return;
+	}
+
+	parallel_data->value = CPMO_OMPT_TOPLEVEL_REGION;
+
+	SPMOOmptState &state = SPMOOmptState::get();
+	if (state.cPmo != nullptr)
+		state.cPmo->parallelPhaseBegin();
+}
+
+
+
+/**
+ * pin each thread of a top-level parallel region if the affinities were changed since its last pinning
+ */
+static void cpmo_ompt_implicit_task(
+		ompt_scope_endpoint_t endpoint,
+		ompt_data_t *parallel_data,
+		ompt_data_t *task_data,
+		unsigned int actual_parallelism,
+		unsigned int index,
+		int flags
+)
+{
+	if (endpoint != ompt_scope_begin)
+		return;
+
+	if (flags & ompt_task_initial)
+	{
+		task_data->value = CPMO_OMPT_INITIAL_TASK;
+		return;
+	}
+
+	if (parallel_data == nullptr || parallel_data->value != CPMO_OMPT_TOPLEVEL_REGION)
+		return;
+
+	SPMOOmptState &state = SPMOOmptState::get();
+
+	static __thread int pinned_generation = -1;
+	static __thread int pinned_cpu = -1;
+
+	if (pinned_generation == state.affinity_generation || state.affinities.empty())
+		return;
+
+	pinned_generation = state.affinity_generation;
+
+	int cpu = state.affinities[index % state.affinities.size()];
+	if (cpu == pinned_cpu)
+		return;
+
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	CPU_SET(cpu, &cpu_set);
+
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0)
+		pinned_cpu = cpu;
+}
+
+
+
+/**
+ * apply the number of threads requested within the finished top-level parallel region
+ */
+static void cpmo_ompt_parallel_end(
+		ompt_data_t *parallel_data,
+		ompt_data_t *encountering_task_data,
+		int flags,
+		const void *codeptr_ra
+)
+{
+	if (parallel_data->value != CPMO_OMPT_TOPLEVEL_REGION)
+		return;
+
+	SPMOOmptState &state = SPMOOmptState::get();
+
+	if (state.pending_num_threads > 0)
+	{
+		omp_set_num_threads(state.pending_num_threads);
+		state.pending_num_threads = -1;
+	}
+
+	if (state.cPmo != nullptr)
+		state.cPmo->parallelPhaseEnd();
+}
+
+
+
+static int cpmo_ompt_initialize(
+		ompt_function_lookup_t lookup,
+		int initial_device_num,
+		ompt_data_t *tool_data
+)
+{
+	ompt_set_callback_t ompt_set_callback = (ompt_set_callback_t)lookup("ompt_set_callback");
+	if (ompt_set_callback == nullptr)
+		return 0;
+
+	if (ompt_set_callback(ompt_callback_parallel_begin, (ompt_callback_t)&cpmo_ompt_parallel_begin) != ompt_set_always)
+		return 0;
+
+	if (ompt_set_callback(ompt_callback_parallel_end, (ompt_callback_t)&cpmo_ompt_parallel_end) != ompt_set_always)
+		return 0;
+
+	if (ompt_set_callback(ompt_callback_implicit_task, (ompt_callback_t)&cpmo_ompt_implicit_task) != ompt_set_always)
+		return 0;
+
+	SPMOOmptState::get().active = true;
+	return 1;
+}
+
+
+
+static void cpmo_ompt_finalize(
+		ompt_data_t *tool_data
+)
+{
+	SPMOOmptState::get().active = false;
+}
+
+
+
+/**
+ * entry point of the tool which is called by the OMP runtime
+ */
+extern "C" ompt_start_tool_result_t *ompt_start_tool(
+		unsigned int omp_version,
+		const char *runtime_version
+)
+{
+	static ompt_start_tool_result_t result = {&cpmo_ompt_initialize, &cpmo_ompt_finalize, {0}};
+	return &result;
+}
+
+#endif
+
+
 
 /*
  * invasive client handler from hell
@@ -34,7 +265,14 @@ class CPMO_OMP	:
 	}
 
 	bool delayed_parallel_region_mode;
-	int delayed_parallel_region_mode_affinity_cache[1024];
+	std::vector<int> delayed_parallel_region_mode_affinity_cache;
+
+	/**
+	 * pinning without OMPT: thread ids of the threads of top-level parallel
+	 * regions and the cpus they are pinned to
+	 */
+	std::vector<pid_t> thread_ids;
+	std::vector<int> thread_pinned_cpus;
 
 public:
 	/**
@@ -55,6 +293,8 @@ public:
 			max_threads = i_max_threads;
 
 		setNumberOfThreads(1);
+
+		SPMOOmptState::get().cPmo = this;
 	}
 
 
@@ -64,6 +304,9 @@ public:
 	 */
 	virtual ~CPMO_OMP()
 	{
+		SPMOOmptState &state = SPMOOmptState::get();
+		if (state.cPmo == this)
+			state.cPmo = nullptr;
 	}
 
 
@@ -75,9 +318,19 @@ public:
 	{
 		num_computing_threads = n;
 
+		if (delayed_parallel_region_mode)
+			return;
+
+		SPMOOmptState &state = SPMOOmptState::get();
 
-		if (!delayed_parallel_region_mode)
-			omp_set_num_threads(n);
+		// within a parallel region, the number of threads is applied at the end of the top-level region
+		if (state.active && omp_in_parallel())
+		{
+			state.pending_num_threads = n;
+			return;
+		}
+
+		omp_set_num_threads(n);
 	}
 
 
@@ -94,7 +347,7 @@ public:
 		// deactivate delayed_parallel_region_mode before calling setAffinities!
 		delayed_parallel_region_mode = false;
 
-		setAffinities(delayed_parallel_region_mode_affinity_cache, num_computing_threads);
+		setAffinities(delayed_parallel_region_mode_affinity_cache.data(), num_computing_threads);
 
 		delayed_parallel_region_mode = true;
 	}
@@ -158,45 +411,116 @@ public:
 
 		if (delayed_parallel_region_mode)
 		{
-			for (int i = 0; i < num_computing_threads; i++)
-				delayed_parallel_region_mode_affinity_cache[i] = i_cpu_affinities[i];
+			delayed_parallel_region_mode_affinity_cache.assign(i_cpu_affinities, i_cpu_affinities+num_computing_threads);
+			return;
+		}
+
+		SPMOOmptState &state = SPMOOmptState::get();
+
+		// the threads pin themselves at the begin of the next top-level parallel region
+		if (state.active)
+		{
+			state.affinities.assign(i_cpu_affinities, i_cpu_affinities+i_number_of_cpu_affinities);
+			state.affinity_generation++;
 			return;
 		}
 
 		assert(i_number_of_cpu_affinities == num_computing_threads);
 
-		#pragma omp parallel for shared(i_cpu_affinities) schedule(static,1)
+		/*
+		 * threads which were recorded before are pinned by the master thread,
+		 * this assumes that the runtime keeps the mapping of thread numbers to
+		 * the threads of its pool (libgomp, LLVM)
+		 */
+		if ((int)thread_ids.size() >= num_computing_threads)
+		{
+			int i;
+			for (i = 0; i < num_computing_threads; i++)
+			{
+				if (thread_pinned_cpus[i] == i_cpu_affinities[i])
+					continue;
+
+				if (!pinThread(thread_ids[i], i_cpu_affinities[i]))
+					break;
+
+				thread_pinned_cpus[i] = i_cpu_affinities[i];
+			}
+
+			if (i == num_computing_threads)
+				return;
+
+			// a thread was terminated by the runtime
+			thread_ids.clear();
+		}
+
+		thread_ids.resize(num_computing_threads);
+		thread_pinned_cpus.assign(num_computing_threads, -1);
+
+		int team_size = 0;
+
+		#pragma omp parallel for shared(i_cpu_affinities, team_size) schedule(static,1)
 		for (int i = 0; i < num_computing_threads; i++)
 		{
+			if (omp_get_thread_num() == 0)
+				team_size = omp_get_num_threads();
+
 #if DEBUG
-			if (i_cpu_affinities[i] >= max_threads)
+			// physical cpu ids are not limited by the number of threads (e.g. sparse cpusets in containers)
+			if (i_cpu_affinities[i] >= CPU_SETSIZE)
 			{
 #pragma omp critical
-				std::cerr << "requested cpu affinity: " << i_cpu_affinities[i] << " with max threads " << max_threads << std::endl;
+				std::cerr << "requested cpu affinity: " << i_cpu_affinities[i] << " exceeds CPU_SETSIZE" << std::endl;
 				assert(false);
 			}
 			assert(i_cpu_affinities[i] >= 0);
-			assert(i_cpu_affinities[i] < max_threads);
 #endif
-			cpu_set_t cpu_set;
-			CPU_ZERO(&cpu_set);
-			CPU_SET(i_cpu_affinities[i], &cpu_set);
-
-			int err;
-			err = pthread_setaffinity_np(
-					pthread_self(),
-					sizeof(cpu_set_t),
-					&cpu_set
-				);
-
-			if (err != 0)
-			{
-				std::cout << err << std::endl;
-				perror("pthread_setaffinity_np");
-				assert(false);
-				exit(-1);
-			}
+			thread_ids[i] = (pid_t)syscall(SYS_gettid);
+
+			pinThread(0, i_cpu_affinities[i]);
+			thread_pinned_cpus[i] = i_cpu_affinities[i];
 		}
+
+		// the team was smaller than requested, record the threads again next time
+		if (team_size != num_computing_threads)
+			thread_ids.clear();
+	}
+
+
+
+	/**
+	 * execute i_body(i) for all i in [i_begin, i_end) in chunks of i_chunk_size iterations
+	 *
+	 * each chunk is executed in a separate parallel region. checkpoint() is
+	 * called between the chunks, hence cores released by the server are
+	 * vacated after the current chunk and not only after the whole loop.
+	 */
+	template <typename T>
+	void parallel_for_chunked(
+			int i_begin,
+			int i_end,
+			int i_chunk_size,
+			T i_body
+	)
+	{
+		assert(!omp_in_parallel());
+
+		if (i_chunk_size < 1)
+			i_chunk_size = 1;
+
+		parallelPhaseBegin();
+
+		for (int c = i_begin; c < i_end; c += i_chunk_size)
+		{
+			checkpoint();
+
+			int chunk_end = std::min(c+i_chunk_size, i_end);
+
+			#pragma omp parallel for schedule(dynamic, 1)
+			for (int i = c; i < chunk_end; i++)
+				i_body(i);
+		}
+
+		parallelPhaseEnd();
 	}
 };
 
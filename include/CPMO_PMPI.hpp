@@ -0,0 +1,251 @@
+/*
+ * CPMO_PMPI.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Interposition of blocking MPI calls with the MPI profiling interface
+ * (PMPI) to lend the cores of a rank to the iPMO server while the rank
+ * waits for other ranks (see CPMO::lend()).
+ *
+ * This header defines the MPI functions itself and has to be included in
+ * exactly one translation unit of the client. Lending is activated with
+ *
+ *   CPMO_PMPI::setup(cPmo);
+ *
+ * Operations which are already completed don't lend any cores: with MPI-3,
+ * collectives are started as nonblocking operations and the cores are only
+ * lent if the operation was not completed by the first test.
+ *
+ * The MPI calls have to be executed by the thread which runs the client
+ * (e.g. MPI_THREAD_FUNNELED) outside of parallel regions.
+ */
+
+#ifndef CPMO_PMPI_HPP_
+#define CPMO_PMPI_HPP_
+
+#include <mpi.h>
+#include "CPMO.hpp"
+
+
+#if MPI_VERSION >= 3
+	#define CPMO_PMPI_CONST	const
+#else
+	#define CPMO_PMPI_CONST
+#endif
+
+
+
+class CPMO_PMPI
+{
+	/**
+	 * client lending its cores (nullptr if deactivated)
+	 */
+	static CPMO *cPmo;
+
+public:
+	/**
+	 * activate lending for blocking MPI calls
+	 */
+	static void setup(
+			CPMO *i_cPmo	///< client, nullptr to deactivate lending
+	)
+	{
+		cPmo = i_cPmo;
+	}
+
+
+	static void begin()
+	{
+		if (cPmo != nullptr)
+			cPmo->lend();
+	}
+
+
+	static void end()
+	{
+		if (cPmo != nullptr)
+			cPmo->lend_end();
+	}
+
+
+	/**
+	 * wait for a request and lend the cores if it is not completed yet
+	 */
+	static int wait(
+			MPI_Request *io_request,
+			MPI_Status *o_status
+	)
+	{
+		int flag = 0;
+		int retval = PMPI_Test(io_request, &flag, o_status);
+		if (retval != MPI_SUCCESS || flag)
+			return retval;
+
+		begin();
+		retval = PMPI_Wait(io_request, o_status);
+		end();
+
+		return retval;
+	}
+};
+
+
+CPMO *CPMO_PMPI::cPmo = nullptr;
+
+
+
+int MPI_Wait(
+		MPI_Request *request,
+		MPI_Status *status
+)
+{
+	return CPMO_PMPI::wait(request, status);
+}
+
+
+
+int MPI_Waitall(
+		int count,
+		MPI_Request array_of_requests[],
+		MPI_Status array_of_statuses[]
+)
+{
+	int flag = 0;
+	int retval = PMPI_Testall(count, array_of_requests, &flag, array_of_statuses);
+	if (retval != MPI_SUCCESS || flag)
+		return retval;
+
+	CPMO_PMPI::begin();
+	retval = PMPI_Waitall(count, array_of_requests, array_of_statuses);
+	CPMO_PMPI::end();
+
+	return retval;
+}
+
+
+
+int MPI_Recv(
+		void *buf,
+		int count,
+		MPI_Datatype datatype,
+		int source,
+		int tag,
+		MPI_Comm comm,
+		MPI_Status *status
+)
+{
+	MPI_Request request;
+	int retval = PMPI_Irecv(buf, count, datatype, source, tag, comm, &request);
+	if (retval != MPI_SUCCESS)
+		return retval;
+
+	return CPMO_PMPI::wait(&request, status);
+}
+
+
+
+#if MPI_VERSION >= 3
+
+int MPI_Barrier(
+		MPI_Comm comm
+)
+{
+	MPI_Request request;
+	int retval = PMPI_Ibarrier(comm, &request);
+	if (retval != MPI_SUCCESS)
+		return retval;
+
+	return CPMO_PMPI::wait(&request, MPI_STATUS_IGNORE);
+}
+
+
+
+int MPI_Bcast(
+		void *buffer,
+		int count,
+		MPI_Datatype datatype,
+		int root,
+		MPI_Comm comm
+)
+{
+	MPI_Request request;
+	int retval = PMPI_Ibcast(buffer, count, datatype, root, comm, &request);
+	if (retval != MPI_SUCCESS)
+		return retval;
+
+	return CPMO_PMPI::wait(&request, MPI_STATUS_IGNORE);
+}
+
+
+
+int MPI_Allreduce(
+		CPMO_PMPI_CONST void *sendbuf,
+		void *recvbuf,
+		int count,
+		MPI_Datatype datatype,
+		MPI_Op op,
+		MPI_Comm comm
+)
+{
+	MPI_Request request;
+	int retval = PMPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, comm, &request);
+	if (retval != MPI_SUCCESS)
+		return retval;
+
+	return CPMO_PMPI::wait(&request, MPI_STATUS_IGNORE);
+}
+
+#else
+
+int MPI_Barrier(
+		MPI_Comm comm
+)
+{
+	CPMO_PMPI::begin();
+	int retval = PMPI_Barrier(comm);
+	CPMO_PMPI::end();
+
+	return retval;
+}
+
+
+
+int MPI_Bcast(
+		void *buffer,
+		int count,
+		MPI_Datatype datatype,
+		int root,
+		MPI_Comm comm
+)
+{
+	CPMO_PMPI::begin();
+	int retval = PMPI_Bcast(buffer, count, datatype, root, comm);
+	CPMO_PMPI::end();
+
+	return retval;
+}
+
+
+
+int MPI_Allreduce(
+		CPMO_PMPI_CONST void *sendbuf,
+		void *recvbuf,
+		int count,
+		MPI_Datatype datatype,
+		MPI_Op op,
+		MPI_Comm comm
+)
+{
+	CPMO_PMPI::begin();
+	int retval = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+	CPMO_PMPI::end();
+
+	return retval;
+}
+
+#endif
+
+
+#endif /* CPMO_PMPI_HPP_ */
@@ -25,13 +25,6 @@
 #include "CPMO.hpp"
 
 
-/*
- * pieces of the following codes are from TBB 4.0, src/perf.cpp
- * http://threadingbuildingblocks.org/
- *
- * the code was slightly modified.
- */
-
 /*
  * invasive client handler for TBB from hell
  */
@@ -49,56 +42,125 @@ public:
 	}
 
 
-	static bool PinTheThread(
-			int cpu_idx,
-			tbb::atomic<int>& nRemainingThreadsForPinning
-	)
+
+private:
+	/**
+	 * records the thread ids of the TBB worker threads
+	 *
+	 * the threads are pinned by the master thread with their thread ids,
+	 * hence no tasks have to be spawned and synchronized for pinning.
+	 * workers entering the scheduler are pinned to their cpu immediately.
+	 */
+	class CThreadObserver	:
+		public tbb::task_scheduler_observer
 	{
-		cpu_set_t orig_mask, target_mask;
-		CPU_ZERO(&target_mask);
-		CPU_SET(cpu_idx, &target_mask);
-		assert(CPU_ISSET(cpu_idx, &target_mask));
-		CPU_ZERO(&orig_mask);
+		CPMO_TBB &cPmoTbb;
+
+	public:
+		CThreadObserver(
+				CPMO_TBB &i_cPmoTbb
+		)	:
+			cPmoTbb(i_cPmoTbb)
+		{
+			observe(true);
+		}
+
+		~CThreadObserver()
+		{
+			observe(false);
+		}
+
+		void on_scheduler_entry(bool i_is_worker)
+		{
+			if (i_is_worker)
+				cPmoTbb.registerWorkerThread(gettid());
+		}
+
+		void on_scheduler_exit(bool i_is_worker)
+		{
+			if (i_is_worker)
+				cPmoTbb.unregisterWorkerThread(gettid());
+		}
+	};
+
+	CThreadObserver *cThreadObserver;
+
+	tbb::mutex threads_mutex;
+
+	/**
+	 * thread ids of the workers in the order they entered the scheduler and their pinned cpus
+	 */
+	std::vector<pid_t> worker_thread_ids;
+	std::vector<int> worker_pinned_cpus;
+
+	/**
+	 * cpu of the master thread (-1: not pinned)
+	 */
+	int master_pinned_cpu;
 
-		int res = sched_getaffinity(gettid(), sizeof(cpu_set_t), &orig_mask);
-		assert(res == 0);
+	/**
+	 * current affinities: master thread first, then the workers
+	 */
+	std::vector<int> cpu_affinities;
 
-		res = sched_setaffinity(gettid(), sizeof(cpu_set_t), &target_mask);
-		assert(res == 0);
 
-		--nRemainingThreadsForPinning;
-		while (nRemainingThreadsForPinning)
-			__TBB_Yield();
 
-		return true;
+	/**
+	 * pin the i-th worker if its cpu changed
+	 *
+	 * threads_mutex has to be locked
+	 */
+	void pinWorkerThread(
+			int i
+	)
+	{
+		if (cpu_affinities.empty())
+			return;
+
+		/*
+		 * TBB doesn't guarantee that the first registered workers serve the
+		 * arena, hence additional workers share the cpus of the client
+		 */
+		int cpu = cpu_affinities[(i+1) % cpu_affinities.size()];
+		if (worker_pinned_cpus[i] == cpu)
+			return;
+
+		if (pinThread(worker_thread_ids[i], cpu))
+			worker_pinned_cpus[i] = cpu;
 	}
 
 
 
-	class CAffinitySetterTask :
-		public tbb::task
+	void registerWorkerThread(
+			pid_t i_tid
+	)
 	{
-	public:
-		static bool m_result;
-		static tbb::atomic<int> m_nThreads;
-		int m_idx;
+		tbb::mutex::scoped_lock lock(threads_mutex);
 
-		tbb::task* execute ()
-		{
-			m_result = PinTheThread(m_idx, m_nThreads);
-			return NULL;
-		}
+		worker_thread_ids.push_back(i_tid);
+		worker_pinned_cpus.push_back(-1);
 
-	public:
-		CAffinitySetterTask(int idx) :
-			m_idx(idx)
-		{}
+		pinWorkerThread(worker_thread_ids.size()-1);
+	}
 
-		friend bool AffinitizeTBB ( int, int /*mode*/ );
-	};
 
 
+	void unregisterWorkerThread(
+			pid_t i_tid
+	)
+	{
+		tbb::mutex::scoped_lock lock(threads_mutex);
+
+		for (size_t i = 0; i < worker_thread_ids.size(); i++)
+		{
+			if (worker_thread_ids[i] != i_tid)
+				continue;
 
+			worker_thread_ids.erase(worker_thread_ids.begin()+i);
+			worker_pinned_cpus.erase(worker_pinned_cpus.begin()+i);
+			return;
+		}
+	}
 
 
 
@@ -113,7 +175,9 @@ public:
 										///< before starting execution in case that MPI is activated
 	)	:
 		CPMO(i_verbosity_level, i_wait_for_ack),
-		tbb_task_scheduler_init(nullptr)
+		tbb_task_scheduler_init(nullptr),
+		cThreadObserver(nullptr),
+		master_pinned_cpu(-1)
 	{
 		if (i_max_threads <= 0)
 			max_threads = tbb::task_scheduler_init::default_num_threads();
@@ -139,6 +203,7 @@ public:
 	 */
 	virtual ~CPMO_TBB()
 	{
+		delete cThreadObserver;
 		delete tbb_task_scheduler_init;
 	}
 
@@ -155,6 +220,10 @@ public:
 			delete tbb_task_scheduler_init;
 
 		tbb_task_scheduler_init = new tbb::task_scheduler_init(num_computing_threads);
+
+		// enable the observer after the scheduler was initialized with the requested number of threads
+		if (cThreadObserver == nullptr)
+			cThreadObserver = new CThreadObserver(*this);
 	}
 
 
@@ -203,25 +272,22 @@ public:
 
 		assert(i_number_of_cpu_affinities == num_computing_threads);
 
-		CAffinitySetterTask::m_result = true;
-		CAffinitySetterTask::m_nThreads = i_number_of_cpu_affinities;
+		tbb::mutex::scoped_lock lock(threads_mutex);
 
-		tbb::task_list  tl;
-		for (int i = 0; i < i_number_of_cpu_affinities; i++)
+		cpu_affinities.assign(i_cpu_affinities, i_cpu_affinities+i_number_of_cpu_affinities);
+
+		// only threads with a changed cpu are pinned
+		if (master_pinned_cpu != cpu_affinities[0])
 		{
-			tbb::task &t = *new(tbb::task::allocate_root()) CAffinitySetterTask(i_cpu_affinities[i]);
-			t.set_affinity(tbb::task::affinity_id(i+1));
-			tl.push_back(t);
+			pinThread(0, cpu_affinities[0]);
+			master_pinned_cpu = cpu_affinities[0];
 		}
-		tbb::task::spawn_root_and_wait(tl);
-
 
+		for (int i = 0; i < (int)worker_thread_ids.size(); i++)
+			pinWorkerThread(i);
 	}
 };
 
-bool CPMO_TBB::CAffinitySetterTask::m_result;
-tbb::atomic<int> CPMO_TBB::CAffinitySetterTask::m_nThreads;
-
 
 
 #endif /* CPMO_HPP_ */
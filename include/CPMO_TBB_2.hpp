@@ -207,6 +207,11 @@ public:
 
 	pid_t *thread_ids;
 
+	/**
+	 * cpus the threads are pinned to (-1: not pinned)
+	 */
+	std::vector<int> thread_pinned_cpus;
+
 
 public:
 	/**
@@ -236,6 +241,7 @@ public:
 		 * allocate storage for thread ids
 		 */
 		thread_ids = new pid_t[max_threads];
+		thread_pinned_cpus.assign(max_threads, -1);
 
 		tbb::atomic<int> wait_for_n_threads;
 		wait_for_n_threads = max_threads;
@@ -425,15 +431,13 @@ public:
 
 		for (int i = 0; i < num_computing_threads; i++)
 		{
-			cpu_set_t orig_mask, target_mask;
-			CPU_ZERO(&target_mask);
-			CPU_SET(i_cpu_affinities[i], &target_mask);
-			assert(CPU_ISSET(i_cpu_affinities[i], &target_mask));
-			CPU_ZERO(&orig_mask);
+			// only threads with a changed cpu are pinned
+			if (thread_pinned_cpus[i] == i_cpu_affinities[i])
+				continue;
 
 //			std::cout << "setting affinity for thread id " << i << " to core " << i_cpu_affinities[i] << std::endl;
-			int res = sched_setaffinity(thread_ids[i], sizeof(cpu_set_t), &target_mask);
-			assert(res == 0);
+			if (pinThread(thread_ids[i], i_cpu_affinities[i]))
+				thread_pinned_cpus[i] = i_cpu_affinities[i];
 		}
 #if 0
 		tbb::atomic<int> wait_for_n_threads;
@@ -0,0 +1,670 @@
+/*
+ * CPMO_Threads.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Invasive client handler with its own work-stealing thread pool based
+ * on std::thread, hence without the restrictions of the OMP and TBB
+ * runtimes on changing the number of threads and their affinities.
+ *
+ * Each worker owns a Chase-Lev deque. The owner pushes and pops tasks at
+ * the bottom, idle workers steal from the top of the deques of all other
+ * workers (also from parked workers, hence no task gets lost on a resize).
+ *
+ * The thread calling parallel_for() is worker 0. Worker i stays pinned to
+ * the i-th core assigned by the server. Workers beyond the number of
+ * assigned cores are parked on a condition variable and are unparked as
+ * soon as the number of threads is increased again.
+ */
+
+#ifndef CPMO_THREADS_HPP_
+#define CPMO_THREADS_HPP_
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cassert>
+
+#include "CPMO.hpp"
+
+
+
+/**
+ * lock-free work-stealing deque (Chase and Lev, "Dynamic circular work-stealing deque", SPAA 2005)
+ *
+ * the capacity is fixed, tasks which can't be pushed are executed by the owner
+ */
+template <typename T>
+class CWorkStealingDeque
+{
+	std::atomic<long> top;
+	std::atomic<long> bottom;
+
+	std::atomic<T*> *buffer;
+	long mask;
+
+public:
+	CWorkStealingDeque(
+			int i_log2_capacity = 12
+	)	:
+		top(0),
+		bottom(0)
+	{
+		long capacity = 1l << i_log2_capacity;
+		mask = capacity-1;
+
+		buffer = new std::atomic<T*>[capacity];
+		for (long i = 0; i < capacity; i++)
+			buffer[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+
+	~CWorkStealingDeque()
+	{
+		delete [] buffer;
+	}
+
+
+	/**
+	 * owner: push a task to the bottom
+	 *
+	 * \return false if the deque is full
+	 */
+	bool push(T *i_task)
+	{
+		long b = bottom.load(std::memory_order_relaxed);
+		long t = top.load(std::memory_order_acquire);
+
+		if (b-t > mask)
+			return false;
+
+		buffer[b & mask].store(i_task, std::memory_order_release);
+		bottom.store(b+1, std::memory_order_release);
+		return true;
+	}
+
+
+	/**
+	 * owner: pop a task from the bottom
+	 */
+	T* pop()
+	{
+		long b = bottom.load(std::memory_order_relaxed)-1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long t = top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			// empty
+			bottom.store(b+1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T *task = buffer[b & mask].load(std::memory_order_relaxed);
+
+		if (t == b)
+		{
+			// last task: race with thieves
+			if (!top.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				task = nullptr;
+
+			bottom.store(b+1, std::memory_order_relaxed);
+		}
+
+		return task;
+	}
+
+
+	/**
+	 * thief: steal a task from the top
+	 */
+	T* steal()
+	{
+		long t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return nullptr;
+
+		T *task = buffer[t & mask].load(std::memory_order_acquire);
+
+		if (!top.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+
+		return task;
+	}
+};
+
+
+
+/*
+ * invasive client handler with a native thread pool
+ */
+class CPMO_Threads	:
+	public CPMO
+{
+	/**
+	 * iteration range of a parallel_for
+	 */
+	struct SJob
+	{
+		std::function<void(int,int)> body;	///< executes the iterations [begin, end)
+		int grain_size;
+		std::atomic<int> remaining;			///< iterations which were not executed so far
+		bool checkpoint;					///< worker 0 calls checkpoint() before each task
+	};
+
+	struct STask
+	{
+		SJob *job;
+		int begin;
+		int end;
+	};
+
+
+	struct SWorker
+	{
+		CWorkStealingDeque<STask> deque;
+
+		std::thread *thread;			///< nullptr for worker 0 and workers which were not started so far
+
+		std::atomic<int> cpu;			///< cpu assigned by the server (-1: none)
+		int pinned_cpu;					///< cpu the thread is currently pinned to
+
+		unsigned int random_seed;		///< victim selection
+
+		SWorker()	:
+			thread(nullptr),
+			cpu(-1),
+			pinned_cpu(-1),
+			random_seed(0)
+		{
+		}
+	};
+
+
+	std::vector<SWorker*> workers;
+
+	/**
+	 * number of workers which are not parked
+	 */
+	std::atomic<int> num_active_workers;
+
+	/**
+	 * number of active workers after the next setAffinities() (-1: unchanged)
+	 */
+	int pending_num_active_workers;
+
+	/**
+	 * number of running parallel_for calls
+	 */
+	std::atomic<int> num_active_jobs;
+
+	bool shutdown_workers;
+
+	/**
+	 * parking of workers and wakeup of idle workers
+	 */
+	std::mutex workers_mutex;
+	std::condition_variable workers_cond;
+
+
+	/**
+	 * id of the calling thread within the pool (-1 if not a worker of this pool)
+	 */
+	static int &getThreadWorkerId()
+	{
+		static __thread int worker_id = -1;
+		return worker_id;
+	}
+
+
+
+	/**
+	 * pin the calling worker if the server assigned another cpu
+	 */
+	void pinWorker(
+			SWorker *io_worker
+	)
+	{
+		int cpu = io_worker->cpu.load(std::memory_order_relaxed);
+		if (cpu < 0 || cpu == io_worker->pinned_cpu)
+			return;
+
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		CPU_SET(cpu, &cpu_set);
+
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0)
+			perror("pthread_setaffinity_np");
+
+		io_worker->pinned_cpu = cpu;
+	}
+
+
+
+	/**
+	 * execute a task and split it until the grain size is reached
+	 */
+	void executeTask(
+			int i_worker_id,
+			STask *i_task
+	)
+	{
+		SJob *job = i_task->job;
+		int begin = i_task->begin;
+		int end = i_task->end;
+		delete i_task;
+
+		// apply pending resource updates, the other workers park/repin after their current task
+		if (job->checkpoint && i_worker_id == 0)
+			checkpoint();
+
+		SWorker *w = workers[i_worker_id];
+
+		// lazy binary splitting: make the upper half available to thieves
+		while (end-begin > job->grain_size)
+		{
+			int mid = begin + (end-begin)/2;
+
+			STask *t = new STask;
+			t->job = job;
+			t->begin = mid;
+			t->end = end;
+
+			if (!w->deque.push(t))
+			{
+				delete t;
+				break;
+			}
+
+			end = mid;
+		}
+
+		job->body(begin, end);
+		job->remaining.fetch_sub(end-begin, std::memory_order_release);
+	}
+
+
+
+	/**
+	 * get a task from the own deque or steal one from another worker
+	 */
+	STask* getTask(
+			int i_worker_id
+	)
+	{
+		SWorker *w = workers[i_worker_id];
+
+		STask *t = w->deque.pop();
+		if (t != nullptr)
+			return t;
+
+		int n = workers.size();
+		int victim = rand_r(&w->random_seed) % n;
+
+		for (int i = 0; i < n; i++)
+		{
+			if (victim != i_worker_id)
+			{
+				t = workers[victim]->deque.steal();
+				if (t != nullptr)
+					return t;
+			}
+
+			victim = (victim+1) % n;
+		}
+
+		return nullptr;
+	}
+
+
+
+	void workerLoop(
+			int i_worker_id
+	)
+	{
+		getThreadWorkerId() = i_worker_id;
+
+		SWorker *w = workers[i_worker_id];
+
+		while (true)
+		{
+			if (	i_worker_id >= num_active_workers.load(std::memory_order_relaxed) ||
+					num_active_jobs.load(std::memory_order_relaxed) == 0
+			)
+			{
+				std::unique_lock<std::mutex> lock(workers_mutex);
+				workers_cond.wait(lock, [&]{
+						return shutdown_workers ||
+								(i_worker_id < num_active_workers.load() && num_active_jobs.load() > 0);
+					});
+
+				if (shutdown_workers)
+					return;
+			}
+
+			pinWorker(w);
+
+			STask *t = getTask(i_worker_id);
+			if (t != nullptr)
+				executeTask(i_worker_id, t);
+			else
+				sched_yield();
+		}
+	}
+
+
+
+	/**
+	 * start the threads of workers [1, n)
+	 */
+	void startWorkers(
+			int n
+	)
+	{
+		for (int i = 1; i < n && i < (int)workers.size(); i++)
+		{
+			if (workers[i]->thread != nullptr)
+				continue;
+
+			workers[i]->thread = new std::thread(&CPMO_Threads::workerLoop, this, i);
+		}
+	}
+
+
+
+public:
+	/**
+	 * constructor
+	 */
+	CPMO_Threads(
+			int i_max_threads = -1,		///< maximum number of threads
+			bool i_verbosity_level = 0,	///< verbosity level
+			bool i_wait_for_ack = true	///< specifies for how many mpi nodes to wait
+										///< before starting execution in case that MPI is activated
+	)	:
+		CPMO(i_verbosity_level, i_wait_for_ack),
+		num_active_workers(1),
+		pending_num_active_workers(-1),
+		num_active_jobs(0),
+		shutdown_workers(false)
+	{
+		if (i_max_threads <= 0)
+		{
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+			if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0)
+				max_threads = CPU_COUNT(&cpu_set);
+			else
+				max_threads = std::thread::hardware_concurrency();
+		}
+		else
+		{
+			max_threads = i_max_threads;
+		}
+
+		if (max_threads <= 0)
+			max_threads = 1;
+
+		workers.resize(max_threads);
+		for (int i = 0; i < max_threads; i++)
+		{
+			workers[i] = new SWorker;
+			workers[i]->random_seed = i+1;
+		}
+
+		getThreadWorkerId() = 0;
+
+		setNumberOfThreads(1);
+	}
+
+
+
+	/**
+	 * deconstructor
+	 */
+	virtual ~CPMO_Threads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(workers_mutex);
+			shutdown_workers = true;
+		}
+		workers_cond.notify_all();
+
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			if (workers[i]->thread != nullptr)
+			{
+				workers[i]->thread->join();
+				delete workers[i]->thread;
+			}
+
+			delete workers[i];
+		}
+
+		getThreadWorkerId() = -1;
+	}
+
+
+
+	/**
+	 * shrink/grow number of threads to use for parallel regions
+	 *
+	 * workers are parked immediately, also during a running parallel_for.
+	 * Additional workers are unparked by the following setAffinities() once
+	 * their new cpus are stored, otherwise they would execute a task on
+	 * their previous cpu first.
+	 */
+	void setNumberOfThreads(int n)
+	{
+		num_computing_threads = n;
+
+		if (n > max_threads)
+			n = max_threads;
+
+		if (n < 1)
+			n = 1;
+
+		startWorkers(n);
+
+		{
+			std::lock_guard<std::mutex> lock(workers_mutex);
+
+			if (n > num_active_workers.load())
+			{
+				pending_num_active_workers = n;
+				return;
+			}
+
+			pending_num_active_workers = -1;
+			num_active_workers = n;
+		}
+		workers_cond.notify_all();
+	}
+
+
+
+	void delayedUpdateNumberOfThreads()
+	{
+		// number of threads is updated immediately
+	}
+
+
+
+	/**
+	 * return the number of running threads
+	 */
+	int getNumberOfThreads()
+	{
+		return num_computing_threads;
+	}
+
+
+
+	/**
+	 * return the maximum allowed number of running threads
+	 */
+	int getMaxNumberOfThreads()
+	{
+		return max_threads;
+	}
+
+
+
+	/**
+	 * set affinities for "num_running_threads" threads
+	 *
+	 * the calling thread is pinned immediately, the other workers before executing their next task
+	 */
+	void setAffinities(
+			const int *i_cpu_affinities,
+			int i_number_of_cpu_affinities
+	)
+	{
+		if (num_computing_threads == 0)
+			return;
+
+		for (int i = 0; i < i_number_of_cpu_affinities && i < (int)workers.size(); i++)
+			workers[i]->cpu.store(i_cpu_affinities[i], std::memory_order_relaxed);
+
+		pinWorker(workers[0]);
+
+		{
+			std::lock_guard<std::mutex> lock(workers_mutex);
+
+			if (pending_num_active_workers < 0)
+				return;
+
+			num_active_workers = pending_num_active_workers;
+			pending_num_active_workers = -1;
+		}
+		workers_cond.notify_all();
+	}
+
+
+
+	/**
+	 * execute i_body(i) for all i in [i_begin, i_end) with the active workers
+	 *
+	 * can be called by worker 0 and also nested by all other workers
+	 */
+	template <typename T>
+	void parallel_for(
+			int i_begin,
+			int i_end,
+			int i_grain_size,
+			T i_body
+	)
+	{
+		parallel_for_internal(i_begin, i_end, i_grain_size, i_body, false);
+	}
+
+
+
+	/**
+	 * execute i_body(i) for all i in [i_begin, i_end) in chunks of i_chunk_size iterations
+	 *
+	 * worker 0 calls checkpoint() between its chunks, hence cores released by
+	 * the server are vacated after the current chunk of each worker and not
+	 * only after the whole loop.
+	 */
+	template <typename T>
+	void parallel_for_chunked(
+			int i_begin,
+			int i_end,
+			int i_chunk_size,
+			T i_body
+	)
+	{
+		parallel_for_internal(i_begin, i_end, i_chunk_size, i_body, getThreadWorkerId() == 0);
+	}
+
+
+
+private:
+	template <typename T>
+	void parallel_for_internal(
+			int i_begin,
+			int i_end,
+			int i_grain_size,
+			T &i_body,
+			bool i_checkpoint
+	)
+	{
+		if (i_end <= i_begin)
+			return;
+
+		int worker_id = getThreadWorkerId();
+
+		// not called by a worker of this pool
+		if (worker_id < 0)
+		{
+			for (int i = i_begin; i < i_end; i++)
+				i_body(i);
+			return;
+		}
+
+		SJob job;
+		job.body = [&i_body](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+					i_body(i);
+			};
+		job.grain_size = (i_grain_size < 1 ? 1 : i_grain_size);
+		job.remaining = i_end-i_begin;
+		job.checkpoint = i_checkpoint;
+
+		if (worker_id == 0)
+			parallelPhaseBegin();
+
+		{
+			std::lock_guard<std::mutex> lock(workers_mutex);
+			num_active_jobs++;
+		}
+		workers_cond.notify_all();
+
+		STask *t = new STask;
+		t->job = &job;
+		t->begin = i_begin;
+		t->end = i_end;
+
+		executeTask(worker_id, t);
+
+		// help the other workers until all iterations were executed
+		while (job.remaining.load(std::memory_order_acquire) > 0)
+		{
+			t = getTask(worker_id);
+			if (t != nullptr)
+			{
+				executeTask(worker_id, t);
+			}
+			else
+			{
+				if (i_checkpoint)
+					checkpoint();
+
+				sched_yield();
+			}
+		}
+
+		num_active_jobs--;
+
+		if (worker_id == 0)
+			parallelPhaseEnd();
+	}
+};
+
+
+
+#endif /* CPMO_THREADS_HPP_ */
@@ -0,0 +1,231 @@
+/*
+ * CScalabilityProfiler.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Online estimation of a scalability graph from measured throughput.
+ *
+ * The client reports the amount of work units processed during a timestep
+ * together with the number of threads which were used. For each number of
+ * threads, an exponentially decaying average of the throughput is stored.
+ *
+ * The scalability graph is then fitted by an isotonic (monotonically
+ * non-decreasing) regression using the pool adjacent violators algorithm.
+ * Sampling points which were not measured so far are interpolated linearly
+ * and extrapolated optimistically to allow the world scheduler to explore
+ * larger numbers of cores.
+ */
+
+#ifndef CSCALABILITYPROFILER_HPP_
+#define CSCALABILITYPROFILER_HPP_
+
+#include <vector>
+#include <cassert>
+#include <cmath>
+
+
+
+class CScalabilityProfiler
+{
+	/**
+	 * maximum number of threads to create the scalability graph for
+	 */
+	int max_threads;
+
+	/**
+	 * weight of previous samples when adding a new sample
+	 * for the same number of threads (0: forget everything, 1: never forget)
+	 */
+	double decay;
+
+	/**
+	 * accumulated (decayed) work units for each number of threads (index: #threads-1)
+	 */
+	std::vector<double> sum_work;
+
+	/**
+	 * accumulated (decayed) time in seconds for each number of threads (index: #threads-1)
+	 */
+	std::vector<double> sum_time;
+
+
+public:
+	CScalabilityProfiler(
+			int i_max_threads,		///< maximum number of threads
+			double i_decay = 0.8	///< weight of previous samples
+	)	:
+		max_threads(i_max_threads),
+		decay(i_decay),
+		sum_work(i_max_threads, 0),
+		sum_time(i_max_threads, 0)
+	{
+		assert(max_threads > 0);
+	}
+
+
+
+	/**
+	 * add a new throughput measurement
+	 */
+	void addSample(
+			int i_num_threads,		///< number of threads used during measurement
+			double i_work_units,	///< processed work units
+			double i_seconds		///< time in seconds to process work units
+	)
+	{
+		if (i_num_threads <= 0 || i_num_threads > max_threads)
+			return;
+
+		if (i_seconds <= 0 || i_work_units <= 0)
+			return;
+
+		int i = i_num_threads-1;
+		sum_work[i] = sum_work[i]*decay + i_work_units;
+		sum_time[i] = sum_time[i]*decay + i_seconds;
+	}
+
+
+
+	/**
+	 * return true if at least one sample is available
+	 */
+	bool samplesAvailable()
+	{
+		for (int i = 0; i < max_threads; i++)
+			if (sum_time[i] > 0)
+				return true;
+
+		return false;
+	}
+
+
+
+	/**
+	 * compute scalability graph
+	 *
+	 * o_graph[n-1] is the estimated speedup for n threads
+	 */
+	void computeScalabilityGraph(
+			std::vector<float> &o_graph		///< output: scalability graph
+	)
+	{
+		o_graph.clear();
+
+		/*
+		 * collect measured sampling points
+		 */
+		std::vector<int> points;			// number of threads
+		std::vector<double> values;			// throughput
+		std::vector<double> weights;		// weight (accumulated time)
+
+		for (int i = 0; i < max_threads; i++)
+		{
+			if (sum_time[i] <= 0)
+				continue;
+
+			points.push_back(i+1);
+			values.push_back(sum_work[i]/sum_time[i]);
+			weights.push_back(sum_time[i]);
+		}
+
+		if (points.empty())
+			return;
+
+
+		/*
+		 * isotonic regression (pool adjacent violators)
+		 *
+		 * each block stores its weighted mean, weight and number of merged points
+		 */
+		std::vector<double> block_value;
+		std::vector<double> block_weight;
+		std::vector<int> block_size;
+
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			block_value.push_back(values[i]);
+			block_weight.push_back(weights[i]);
+			block_size.push_back(1);
+
+			while (block_value.size() > 1 && block_value[block_value.size()-2] > block_value.back())
+			{
+				size_t b = block_value.size()-2;
+				double w = block_weight[b] + block_weight[b+1];
+				block_value[b] = (block_value[b]*block_weight[b] + block_value[b+1]*block_weight[b+1])/w;
+				block_weight[b] = w;
+				block_size[b] += block_size[b+1];
+
+				block_value.pop_back();
+				block_weight.pop_back();
+				block_size.pop_back();
+			}
+		}
+
+		std::vector<double> fitted;
+		for (size_t b = 0; b < block_value.size(); b++)
+			for (int i = 0; i < block_size[b]; i++)
+				fitted.push_back(block_value[b]);
+
+		assert(fitted.size() == points.size());
+
+
+		/*
+		 * normalize throughput to speedup
+		 *
+		 * the first sampling point is assumed to scale linearly
+		 */
+		double speedup_normalization = (double)points[0]/fitted[0];
+
+		for (size_t i = 0; i < fitted.size(); i++)
+			fitted[i] *= speedup_normalization;
+
+
+		/*
+		 * setup graph with interpolated and extrapolated values
+		 */
+		o_graph.resize(max_threads);
+
+		// slope for extrapolation beyond the last measured sampling point
+		double slope;
+		if (points.size() == 1)
+			slope = fitted[0]/(double)points[0];
+		else
+			slope = (fitted.back()-fitted[fitted.size()-2])/(double)(points.back()-points[points.size()-2]);
+
+		size_t p = 0;
+		for (int n = 1; n <= max_threads; n++)
+		{
+			while (p < points.size() && points[p] < n)
+				p++;
+
+			double s;
+			if (p < points.size() && points[p] == n)
+			{
+				s = fitted[p];
+			}
+			else if (p == 0)
+			{
+				// before first sampling point: linear from origin
+				s = fitted[0]*(double)n/(double)points[0];
+			}
+			else if (p == points.size())
+			{
+				// after last sampling point: optimistic extrapolation
+				s = fitted.back() + slope*(double)(n-points.back());
+			}
+			else
+			{
+				// linear interpolation between sampling points
+				double a = (double)(n-points[p-1])/(double)(points[p]-points[p-1]);
+				s = fitted[p-1]*(1.0-a) + fitted[p]*a;
+			}
+
+			o_graph[n-1] = (float)s;
+		}
+	}
+};
+
+
+#endif /* CSCALABILITYPROFILER_HPP_ */
@@ -21,6 +21,7 @@ public:
 
 		CLIENT_INVADE,				///< invade
 		SERVER_INVADE_ANSWER,		///< invade answer from server
+		SERVER_INVADE_QUEUED,		///< no core is free, the invade is answered after the client was admitted
 
 		CLIENT_INVADE_NONBLOCKING,	///< async invade:
 									///< (send new constraints/hints to system)
@@ -36,6 +37,10 @@ public:
 
 		CLIENT_RETREAT,				///< retreat from resources
 
+		CLIENT_LEND,				///< temporarily lend all cores except the first one to the server
+									///< (e.g. while waiting in a blocking MPI call)
+		CLIENT_LEND_END,			///< end of lending, the lent cores are returned asynchronously
+
 		SERVER_ACK,					///< ack for blocking communication
 		SERVER_QUIT,				///< resource manager is shutdown -> quit messages to client
 
@@ -54,6 +59,7 @@ public:
 		{
 			pid_t pid;
 			unsigned long seq_id;
+			int group_id;			///< clients with the same group id > 0 are coupled (0: no group)
 		} client_setup;
 
 
@@ -85,6 +91,12 @@ public:
 
 			float distribution_hint;
 
+			int priority_class;		///< priority class (higher values are preferred)
+			float weight;			///< weight of scalability within priority class
+
+			float remaining_work;	///< remaining work in seconds on a single core (<= 0: no deadline)
+			float deadline;			///< seconds until the remaining work should be finished (<= 0: as early as possible)
+
 			int scalability_graph_size;
 
 			float scalability_graph[1];
@@ -105,6 +117,13 @@ public:
 		} retreat;
 
 
+		struct
+		{
+			pid_t pid;
+			unsigned long seq_id;
+		} lend;
+
+
 		struct
 		{
 			pid_t pid;
@@ -119,6 +138,14 @@ public:
 			unsigned long seq_id;
 		} ack;
 
+		struct
+		{
+			pid_t pid;
+			unsigned long seq_id;
+			int position;			///< position in the admission queue (1: next client)
+			int queue_length;		///< number of queued clients
+		} invade_queued;
+
 		struct
 		{
 			unsigned long seq_id;
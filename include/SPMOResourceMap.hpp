@@ -0,0 +1,153 @@
+/*
+ * SPMOResourceMap.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Layout of the shared memory segment which is exported by the world
+ * scheduler for monitoring tools.
+ *
+ * The server is the only writer. Consistent snapshots are read with a
+ * sequence lock: the sequence number is odd while the server updates the
+ * segment. A reader copies the segment and retries if the sequence number
+ * was odd or changed during the copy. Readers therefore never block the
+ * server and no message has to be exchanged.
+ */
+
+#ifndef SPMORESOURCEMAP_HPP
+#define SPMORESOURCEMAP_HPP
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/**
+ * name of the shared memory segment (see shm_open)
+ */
+#define PMO_RESOURCE_MAP_NAME			"/ipmo_resource_map"
+
+#define PMO_RESOURCE_MAP_VERSION		1
+
+#define PMO_RESOURCE_MAP_MAX_CORES		1024
+#define PMO_RESOURCE_MAP_MAX_CLIENTS	256
+
+
+
+/**
+ * information on a single client
+ */
+struct SPMOResourceMapClient
+{
+	int client_id;
+	pid_t pid;
+
+	int constraint_min_cores;
+	int constraint_max_cores;
+
+	int priority_class;
+	float weight;
+
+	int number_of_assigned_cores;	///< currently assigned cores
+	int optimal_cores;				///< number of cores computed by the global optimization
+
+	float scalability_assigned;		///< scalability for the currently assigned cores
+	float scalability_optimal;		///< scalability for the optimal number of cores
+};
+
+
+
+struct SPMOResourceMap
+{
+	/**
+	 * sequence number, odd while the segment is updated
+	 */
+	volatile uint32_t seq;
+
+	/**
+	 * layout version (PMO_RESOURCE_MAP_VERSION)
+	 */
+	uint32_t version;
+
+	pid_t server_pid;
+
+	/**
+	 * time since server start of the last update
+	 */
+	double timestamp;
+
+	int max_cores;
+	int num_allocatable_cores;
+
+	/**
+	 * pid for each logical core (0: free, -1: reserved, -2: unavailable)
+	 */
+	pid_t core_pids[PMO_RESOURCE_MAP_MAX_CORES];
+
+	/**
+	 * physical cpu id for each logical core
+	 */
+	int physical_cpu_ids[PMO_RESOURCE_MAP_MAX_CORES];
+
+	/**
+	 * result of the last global optimization
+	 */
+	int optimizer_dp;				///< 1 if computed by the dynamic programming solver
+	double optimizer_seconds;		///< time to compute the last optimum
+	float optimizer_objective;		///< accumulated scalability of the optimum
+
+	int num_clients;
+	SPMOResourceMapClient clients[PMO_RESOURCE_MAP_MAX_CLIENTS];
+
+
+
+	/**
+	 * start updating the segment (writer)
+	 */
+	void beginWrite()
+	{
+		seq++;
+		__sync_synchronize();
+	}
+
+
+	/**
+	 * finish updating the segment (writer)
+	 */
+	void endWrite()
+	{
+		__sync_synchronize();
+		seq++;
+	}
+
+
+	/**
+	 * copy a consistent snapshot of this segment (reader)
+	 *
+	 * \return false if no consistent snapshot was available after i_max_retries
+	 */
+	bool readSnapshot(
+			SPMOResourceMap &o_snapshot,
+			int i_max_retries = 1000
+	)	const
+	{
+		for (int i = 0; i < i_max_retries; i++)
+		{
+			uint32_t s1 = seq;
+			if (s1 & 1)
+				continue;
+
+			__sync_synchronize();
+			memcpy((void*)&o_snapshot, (const void*)this, sizeof(SPMOResourceMap));
+			__sync_synchronize();
+
+			if (seq == s1)
+				return true;
+		}
+
+		return false;
+	}
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Live view of the resource distribution of the world scheduler.
+ *
+ * The resource map is read from the shared memory segment exported by the
+ * server (see SPMOResourceMap). No messages are sent to the server.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "../include/SPMOResourceMap.hpp"
+
+
+
+/**
+ * map the shared memory segment read-only
+ *
+ * \return nullptr if the segment is not available
+ */
+const SPMOResourceMap *openResourceMap()
+{
+	int fd = shm_open(PMO_RESOURCE_MAP_NAME, O_RDONLY, 0);
+	if (fd < 0)
+		return nullptr;
+
+	void *p = mmap(nullptr, sizeof(SPMOResourceMap), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (p == MAP_FAILED)
+		return nullptr;
+
+	return (const SPMOResourceMap*)p;
+}
+
+
+
+void printResourceMap(
+		const SPMOResourceMap &r
+)
+{
+	std::cout << "iPMO server " << r.server_pid << "    time: " << r.timestamp << "s" << std::endl;
+	std::cout << "cores: " << r.max_cores << " (" << r.num_allocatable_cores << " allocatable)    ";
+	std::cout << "clients: " << r.num_clients << "    ";
+	std::cout << "optimizer: " << (r.optimizer_dp ? "dp" : "greedy") << " " << r.optimizer_seconds << "s, objective " << r.optimizer_objective << std::endl;
+	std::cout << std::endl;
+
+	std::map<pid_t, int> pid_to_client_id;
+	for (int i = 0; i < r.num_clients; i++)
+		pid_to_client_id[r.clients[i].pid] = r.clients[i].client_id;
+
+	/*
+	 * core map: client id for each core, '.' for free, 'S' for reserved and 'X' for unavailable cores
+	 */
+	std::cout << "CORE MAP (cpu: client)" << std::endl;
+	for (int i = 0; i < r.max_cores; i++)
+	{
+		std::cout << std::setw(5) << r.physical_cpu_ids[i] << ": ";
+
+		pid_t pid = r.core_pids[i];
+		if (pid == 0)
+			std::cout << std::setw(4) << ".";
+		else if (pid == -1)
+			std::cout << std::setw(4) << "S";
+		else if (pid == -2)
+			std::cout << std::setw(4) << "X";
+		else if (pid_to_client_id.count(pid))
+			std::cout << std::setw(4) << pid_to_client_id[pid];
+		else
+			std::cout << std::setw(4) << "?";
+
+		if (i % 8 == 7 || i+1 == r.max_cores)
+			std::cout << std::endl;
+	}
+	std::cout << std::endl;
+
+	std::cout << "CLIENTS" << std::endl;
+	std::cout << std::setw(6) << "id" << std::setw(8) << "pid";
+	std::cout << std::setw(6) << "min" << std::setw(6) << "max";
+	std::cout << std::setw(6) << "prio" << std::setw(8) << "weight";
+	std::cout << std::setw(7) << "cores" << std::setw(9) << "optimal";
+	std::cout << std::setw(10) << "speedup" << std::setw(10) << "optimal" << std::endl;
+
+	for (int i = 0; i < r.num_clients; i++)
+	{
+		const SPMOResourceMapClient &c = r.clients[i];
+
+		std::cout << std::setw(6) << c.client_id << std::setw(8) << c.pid;
+		std::cout << std::setw(6) << c.constraint_min_cores << std::setw(6) << c.constraint_max_cores;
+		std::cout << std::setw(6) << c.priority_class << std::setw(8) << c.weight;
+		std::cout << std::setw(7) << c.number_of_assigned_cores << std::setw(9) << c.optimal_cores;
+		std::cout << std::setw(10) << c.scalability_assigned << std::setw(10) << c.scalability_optimal << std::endl;
+	}
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	double interval = 1.0;
+	int iterations = -1;
+	bool batch_mode = false;
+
+	char optchar;
+	while ((optchar = getopt(argc, argv, "bi:n:")) > 0)
+	{
+		switch(optchar)
+		{
+		case 'i':
+			interval = atof(optarg);
+			break;
+
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+
+		case 'b':
+			batch_mode = true;
+			break;
+
+		default:
+			std::cout << "usage: " << argv[0] << std::endl;
+			std::cout << "	[-i [float]: update interval in seconds, default: 1]" << std::endl;
+			std::cout << "	[-n [int]: number of updates, default: unlimited]" << std::endl;
+			std::cout << "	[-b : batch mode, don't clear screen]" << std::endl;
+			return -1;
+		}
+	}
+
+	const SPMOResourceMap *resource_map = nullptr;
+	SPMOResourceMap *snapshot = new SPMOResourceMap;
+
+	for (int i = 0; iterations < 0 || i < iterations; i++)
+	{
+		if (i > 0)
+			usleep((useconds_t)(interval*1000000.0));
+
+		if (!batch_mode)
+			std::cout << "\033[2J\033[H";
+
+		if (resource_map == nullptr)
+			resource_map = openResourceMap();
+
+		if (resource_map == nullptr)
+		{
+			std::cout << "No resource map available (server not running?)" << std::endl;
+			continue;
+		}
+
+		if (!resource_map->readSnapshot(*snapshot))
+		{
+			std::cout << "No consistent resource map available" << std::endl;
+			continue;
+		}
+
+		if (snapshot->version != PMO_RESOURCE_MAP_VERSION)
+		{
+			std::cout << "Resource map version " << snapshot->version << " not supported" << std::endl;
+			continue;
+		}
+
+		printResourceMap(*snapshot);
+		std::cout << std::flush;
+	}
+
+	delete snapshot;
+
+	return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * CAdmissionQueue.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Queue of clients whose invade could not be answered since no core was
+ * free.
+ *
+ * The clients are ordered by descending priority class and by the time
+ * they were queued within a priority class. The world scheduler only tries
+ * to admit the clients at the front of the queue after cores were released
+ * (see CResources::core_release_events) instead of searching all waiting
+ * clients after each message.
+ *
+ * The time each client waited in the queue is accounted.
+ */
+
+#ifndef CADMISSIONQUEUE_HPP_
+#define CADMISSIONQUEUE_HPP_
+
+#include <list>
+#include <algorithm>
+#include <sys/types.h>
+
+
+
+class CAdmissionQueue
+{
+public:
+	struct SEntry
+	{
+		pid_t pid;
+		int priority_class;
+		double enqueue_timestamp;
+	};
+
+private:
+	/**
+	 * queued clients in the order of their admission
+	 */
+	std::list<SEntry> entries;
+
+public:
+	/**
+	 * value of CResources::core_release_events when the queue was processed last
+	 */
+	unsigned long processed_release_events;
+
+	/**
+	 * statistics: number of admitted clients and their wait time
+	 */
+	int num_admitted;
+	double sum_wait_time;
+	double max_wait_time;
+
+
+
+	CAdmissionQueue()	:
+		processed_release_events(0),
+		num_admitted(0),
+		sum_wait_time(0),
+		max_wait_time(0)
+	{
+	}
+
+
+
+	bool empty()	const
+	{
+		return entries.empty();
+	}
+
+
+
+	int size()	const
+	{
+		return entries.size();
+	}
+
+
+
+	const SEntry &front()	const
+	{
+		return entries.front();
+	}
+
+
+
+	/**
+	 * queue a client or update the priority class of a queued client
+	 *
+	 * \return position of the client in the queue (1: next client to be admitted)
+	 */
+	int push(
+			pid_t i_pid,
+			int i_priority_class,
+			double i_timestamp
+	)
+	{
+		SEntry e;
+		e.pid = i_pid;
+		e.priority_class = i_priority_class;
+		e.enqueue_timestamp = i_timestamp;
+
+		// a queued client keeps its original timestamp
+		for (std::list<SEntry>::iterator i = entries.begin(); i != entries.end(); i++)
+		{
+			if (i->pid != i_pid)
+				continue;
+
+			e.enqueue_timestamp = i->enqueue_timestamp;
+			entries.erase(i);
+			break;
+		}
+
+		int position = 1;
+		std::list<SEntry>::iterator i = entries.begin();
+
+		for (; i != entries.end(); i++, position++)
+		{
+			if (i->priority_class < e.priority_class)
+				break;
+
+			if (i->priority_class == e.priority_class && i->enqueue_timestamp > e.enqueue_timestamp)
+				break;
+		}
+
+		entries.insert(i, e);
+		return position;
+	}
+
+
+
+	/**
+	 * remove a client, e.g. after its shutdown
+	 *
+	 * \return false if the client was not queued
+	 */
+	bool remove(
+			pid_t i_pid
+	)
+	{
+		for (std::list<SEntry>::iterator i = entries.begin(); i != entries.end(); i++)
+		{
+			if (i->pid != i_pid)
+				continue;
+
+			entries.erase(i);
+			return true;
+		}
+
+		return false;
+	}
+
+
+
+	/**
+	 * remove the front client after it was admitted
+	 *
+	 * \return time the client waited in the queue
+	 */
+	double popFront(
+			double i_timestamp
+	)
+	{
+		double wait_time = i_timestamp - entries.front().enqueue_timestamp;
+		entries.pop_front();
+
+		num_admitted++;
+		sum_wait_time += wait_time;
+		max_wait_time = std::max(max_wait_time, wait_time);
+
+		return wait_time;
+	}
+};
+
+
+#endif /* CADMISSIONQUEUE_HPP_ */
@@ -0,0 +1,288 @@
+/*
+ * CAllocationPredictor.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Precomputed solutions of the global optimization for predicted problems.
+ *
+ * Periodic workloads (e.g. the timesteps of client_mpi_tbb) lead to the same
+ * problems of the global optimization over and over again. After each
+ * invade, the next distribution hint of each client is predicted from its
+ * time series and the optimum of the resulting problem is computed in
+ * advance. To bound the latency of the message handling, only the problem
+ * of a single client is precomputed per invade (round robin over the
+ * clients). The solutions of solved problems are kept as well.
+ *
+ * A plan is only used if the problem of the solver (bounds, values, priority
+ * classes, groups and frequency factors) is exactly the same, hence mispredictions fall
+ * back to the solver without changing any distribution.
+ *
+ * The hit rate and the latency of the global optimization with and without
+ * hits are accounted.
+ */
+
+#ifndef CALLOCATIONPREDICTOR_HPP_
+#define CALLOCATIONPREDICTOR_HPP_
+
+#include <vector>
+#include <list>
+#include <iostream>
+
+#include "CGlobalOptimizer.hpp"
+
+
+
+class CAllocationPredictor
+{
+	struct SPlan
+	{
+		int num_cores;
+		std::vector<int> lower;
+		std::vector<int> upper;
+		std::vector<std::vector<double> > values;	///< values within the bounds (lower..upper) of each client
+		std::vector<int> priority_class;
+		std::vector<int> groups;
+		std::vector<double> work;
+		std::vector<double> frequency_factor;
+
+		std::vector<int> distribution;
+	};
+
+	/**
+	 * plans ordered by their last use
+	 */
+	std::list<SPlan> plans;
+
+
+	/**
+	 * return true if the plan solves the current problem of the optimizer
+	 */
+	static bool matches(
+			const SPlan &i_plan,
+			const CGlobalOptimizer &i_cGlobalOptimizer
+	)
+	{
+		if (i_plan.num_cores != i_cGlobalOptimizer.num_cores)
+			return false;
+
+		if (i_plan.lower != i_cGlobalOptimizer.lower || i_plan.upper != i_cGlobalOptimizer.upper)
+			return false;
+
+		if (i_plan.priority_class != i_cGlobalOptimizer.priority_class)
+			return false;
+
+		if (i_plan.groups != i_cGlobalOptimizer.groups || i_plan.work != i_cGlobalOptimizer.work)
+			return false;
+
+		if (i_plan.frequency_factor != i_cGlobalOptimizer.frequency_factor)
+			return false;
+
+		// only the values within the bounds are used
+		for (size_t c = 0; c < i_plan.values.size(); c++)
+			for (int n = i_plan.lower[c]; n <= i_plan.upper[c]; n++)
+				if (i_plan.values[c][n-i_plan.lower[c]] != i_cGlobalOptimizer.values[c][n])
+					return false;
+
+		return true;
+	}
+
+
+public:
+	/**
+	 * true if predictions are activated
+	 */
+	bool active;
+
+	/**
+	 * maximum number of plans
+	 */
+	int max_plans;
+
+	/**
+	 * maximum length of the time series of the distribution hints
+	 */
+	static const int max_history = 16;
+
+	/**
+	 * index of the client whose next problem is precomputed next
+	 */
+	int next_client;
+
+	/**
+	 * statistics
+	 */
+	int hits;
+	int misses;
+	double hit_seconds;
+	double miss_seconds;
+
+
+
+	CAllocationPredictor()	:
+		active(false),
+		max_plans(16),
+		next_client(0),
+		hits(0),
+		misses(0),
+		hit_seconds(0),
+		miss_seconds(0)
+	{
+	}
+
+
+
+	/**
+	 * predict the next value of a time series
+	 *
+	 * periodic series (period up to 8) repeat their values, series with a
+	 * constant first or second difference are extrapolated linearly or
+	 * quadratically.
+	 *
+	 * \return false if no prediction is possible
+	 */
+	static bool predictNext(
+			const std::vector<float> &i_history,
+			float &o_value
+	)
+	{
+		int n = i_history.size();
+
+		for (int p = 1; p <= 8 && 2*p <= n; p++)
+		{
+			bool periodic = true;
+			for (int i = 0; i < p && periodic; i++)
+				periodic = (i_history[n-1-i] == i_history[n-1-p-i]);
+
+			if (periodic)
+			{
+				o_value = i_history[n-p];
+				return true;
+			}
+		}
+
+		if (n >= 3 && i_history[n-1]-i_history[n-2] == i_history[n-2]-i_history[n-3])
+		{
+			o_value = 2.0f*i_history[n-1]-i_history[n-2];
+			return true;
+		}
+
+		if (n >= 4)
+		{
+			float d2 = i_history[n-1]-2.0f*i_history[n-2]+i_history[n-3];
+
+			if (d2 == i_history[n-2]-2.0f*i_history[n-3]+i_history[n-4])
+			{
+				o_value = 3.0f*i_history[n-1]-3.0f*i_history[n-2]+i_history[n-3];
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+
+
+	/**
+	 * search for a plan solving the current problem of the optimizer
+	 *
+	 * \return false if there's no such plan
+	 */
+	bool lookup(
+			const CGlobalOptimizer &i_cGlobalOptimizer,
+			std::vector<int> &o_distribution
+	)
+	{
+		for (std::list<SPlan>::iterator i = plans.begin(); i != plans.end(); i++)
+		{
+			if (!matches(*i, i_cGlobalOptimizer))
+				continue;
+
+			o_distribution = i->distribution;
+
+			// move to front
+			plans.splice(plans.begin(), plans, i);
+			return true;
+		}
+
+		return false;
+	}
+
+
+
+	/**
+	 * store the solution of the current problem of the optimizer
+	 */
+	void store(
+			const CGlobalOptimizer &i_cGlobalOptimizer,
+			const std::vector<int> &i_distribution
+	)
+	{
+		SPlan p;
+		p.num_cores = i_cGlobalOptimizer.num_cores;
+		p.lower = i_cGlobalOptimizer.lower;
+		p.upper = i_cGlobalOptimizer.upper;
+
+		p.values.resize(p.lower.size());
+		for (size_t c = 0; c < p.values.size(); c++)
+			p.values[c].assign(
+					i_cGlobalOptimizer.values[c].begin()+p.lower[c],
+					i_cGlobalOptimizer.values[c].begin()+p.upper[c]+1
+				);
+
+		p.priority_class = i_cGlobalOptimizer.priority_class;
+		p.groups = i_cGlobalOptimizer.groups;
+		p.work = i_cGlobalOptimizer.work;
+		p.frequency_factor = i_cGlobalOptimizer.frequency_factor;
+		p.distribution = i_distribution;
+
+		plans.push_front(p);
+
+		while ((int)plans.size() > max_plans)
+			plans.pop_back();
+	}
+
+
+
+	/**
+	 * account a global optimization
+	 */
+	void account(
+			bool i_hit,
+			double i_seconds
+	)
+	{
+		if (i_hit)
+		{
+			hits++;
+			hit_seconds += i_seconds;
+		}
+		else
+		{
+			misses++;
+			miss_seconds += i_seconds;
+		}
+	}
+
+
+
+	void printStatistics()
+	{
+		std::cout << "PREDICTION: " << hits << " hits, " << misses << " misses";
+
+		if (hits+misses > 0)
+			std::cout << ", hit rate " << (double)hits/(double)(hits+misses);
+
+		if (hits > 0)
+			std::cout << ", latency with hit " << hit_seconds/(double)hits << "s";
+
+		if (misses > 0)
+			std::cout << ", latency with miss " << miss_seconds/(double)misses << "s";
+
+		std::cout << std::endl;
+	}
+};
+
+
+#endif /* CALLOCATIONPREDICTOR_HPP_ */
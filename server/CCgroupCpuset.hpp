@@ -0,0 +1,352 @@
+/*
+ * CCgroupCpuset.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Server side enforcement of the core distribution with cgroup v2 cpusets.
+ *
+ * For each client, a cgroup [base]/ipmo_client_[id] is created, the
+ * client process is moved to this cgroup and its assigned cores are
+ * written to cpuset.cpus. A client is therefore restricted to its cores
+ * even if it does not pin its threads cooperatively.
+ *
+ * The base directory has to be a cgroup with the cpuset controller
+ * available, e.g. created with
+ *
+ *   mkdir /sys/fs/cgroup/ipmo
+ *   echo +cpuset > /sys/fs/cgroup/cgroup.subtree_control
+ *
+ * cpuset.cpus is only written if the core set of a client changed.
+ *
+ * The base directory can be replaced by an arbitrary (fake) directory,
+ * the cgroup files are then created as regular files.
+ */
+
+#ifndef CCGROUPCPUSET_HPP_
+#define CCGROUPCPUSET_HPP_
+
+#include <map>
+#include <list>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+
+class CCgroupCpuset
+{
+	/**
+	 * state of the cgroup of a client
+	 */
+	struct SClientCgroup
+	{
+		pid_t pid;				///< pid of client
+		std::string cpus;		///< last value written to cpuset.cpus
+		bool active;			///< false if the client was not updated during the last flush
+	};
+
+	/**
+	 * base directory of the cgroups
+	 */
+	std::string base_path;
+
+	/**
+	 * cgroups of the clients (key: client id)
+	 */
+	std::map<int, SClientCgroup> client_cgroups;
+
+	/**
+	 * cgroups which could not be removed so far since processes are still running in them
+	 */
+	std::list<std::string> stale_cgroup_paths;
+
+	bool available;
+
+	int verbosity_level;
+
+
+
+	std::string getClientPath(
+			int i_client_id
+	)
+	{
+		std::ostringstream s;
+		s << base_path << "/ipmo_client_" << i_client_id;
+		return s.str();
+	}
+
+
+
+	/**
+	 * write a value to a cgroup interface file
+	 */
+	bool writeFile(
+			const std::string &i_filename,
+			const std::string &i_value
+	)
+	{
+		int fd = open(i_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+		{
+			if (verbosity_level > 1)
+				std::cerr << "cgroup: failed to open " << i_filename << " (" << strerror(errno) << ")" << std::endl;
+			return false;
+		}
+
+		ssize_t s = write(fd, i_value.c_str(), i_value.size());
+		int err = errno;
+		close(fd);
+
+		if (s != (ssize_t)i_value.size())
+		{
+			if (verbosity_level > 1)
+				std::cerr << "cgroup: failed to write '" << i_value << "' to " << i_filename << " (" << strerror(err) << ")" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * try to remove a cgroup
+	 *
+	 * \return false if processes are still running in this cgroup
+	 */
+	bool removeCgroup(
+			const std::string &i_path
+	)
+	{
+		// interface files can't be removed in a cgroupfs but have to be removed in a fake directory
+		unlink((i_path+"/cgroup.procs").c_str());
+		unlink((i_path+"/cpuset.cpus").c_str());
+
+		if (rmdir(i_path.c_str()) == 0 || errno == ENOENT)
+			return true;
+
+		return false;
+	}
+
+
+
+	/**
+	 * convert a list of cores to the kernel format (e.g. "0-3,8")
+	 */
+	static std::string getCpuListString(
+			const std::list<int> &i_cores
+	)
+	{
+		std::vector<int> cores(i_cores.begin(), i_cores.end());
+		std::sort(cores.begin(), cores.end());
+
+		std::ostringstream s;
+
+		size_t i = 0;
+		while (i < cores.size())
+		{
+			size_t j = i;
+			while (j+1 < cores.size() && cores[j+1] == cores[j]+1)
+				j++;
+
+			if (i > 0)
+				s << ",";
+
+			s << cores[i];
+			if (j > i)
+				s << "-" << cores[j];
+
+			i = j+1;
+		}
+
+		return s.str();
+	}
+
+
+
+public:
+	CCgroupCpuset()	:
+		available(false),
+		verbosity_level(0)
+	{
+	}
+
+
+
+	~CCgroupCpuset()
+	{
+		beginUpdate();
+		endUpdate();
+	}
+
+
+
+	/**
+	 * setup cgroup base directory
+	 *
+	 * \return false if the base directory is not available
+	 */
+	bool setup(
+			const char *i_base_path,	///< base directory of the cgroups
+			int i_verbosity_level
+	)
+	{
+		base_path = i_base_path;
+		verbosity_level = i_verbosity_level;
+
+		struct stat st;
+		if (stat(base_path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+		{
+			std::cerr << "cgroup: base directory " << base_path << " not available" << std::endl;
+			available = false;
+			return false;
+		}
+
+		// enable cpuset controller for the client cgroups (only in a cgroupfs)
+		std::string subtree_control = base_path+"/cgroup.subtree_control";
+		if (access(subtree_control.c_str(), F_OK) == 0)
+			writeFile(subtree_control, "+cpuset");
+
+		available = true;
+		return true;
+	}
+
+
+
+	/**
+	 * return true if cgroup enforcement is available
+	 */
+	bool isAvailable()
+	{
+		return available;
+	}
+
+
+
+	/**
+	 * update the cpuset of a client
+	 *
+	 * the cgroup of the client is created during the first update
+	 */
+	void updateClient(
+			int i_client_id,				///< client id
+			pid_t i_pid,					///< pid of client
+			const std::list<int> &i_cores	///< cores assigned to the client
+	)
+	{
+		if (!available)
+			return;
+
+		std::string path = getClientPath(i_client_id);
+
+		std::map<int, SClientCgroup>::iterator iter = client_cgroups.find(i_client_id);
+
+		if (iter == client_cgroups.end())
+		{
+			if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+			{
+				if (verbosity_level > 1)
+					std::cerr << "cgroup: failed to create " << path << " (" << strerror(errno) << ")" << std::endl;
+				return;
+			}
+
+			SClientCgroup c;
+			c.pid = i_pid;
+			c.active = true;
+
+			iter = client_cgroups.insert(std::pair<int, SClientCgroup>(i_client_id, c)).first;
+
+			// the cpuset has to be setup before the process is moved
+			std::string cpus = getCpuListString(i_cores);
+			if (!cpus.empty() && writeFile(path+"/cpuset.cpus", cpus))
+				iter->second.cpus = cpus;
+
+			std::ostringstream pid;
+			pid << i_pid;
+			writeFile(path+"/cgroup.procs", pid.str());
+
+			if (verbosity_level > 2)
+				std::cout << "cgroup: created " << path << " for pid " << i_pid << std::endl;
+		}
+
+		SClientCgroup &c = iter->second;
+		c.active = true;
+
+		if (i_cores.empty())
+			return;
+
+		std::string cpus = getCpuListString(i_cores);
+		if (cpus == c.cpus)
+			return;
+
+		if (writeFile(path+"/cpuset.cpus", cpus))
+			c.cpus = cpus;
+
+		if (verbosity_level > 5)
+			std::cout << "cgroup: " << path << "/cpuset.cpus = " << cpus << std::endl;
+	}
+
+
+
+	/**
+	 * start updating all clients
+	 *
+	 * clients which are not updated until endUpdate() are removed
+	 */
+	void beginUpdate()
+	{
+		for (std::map<int, SClientCgroup>::iterator iter = client_cgroups.begin(); iter != client_cgroups.end(); iter++)
+			iter->second.active = false;
+	}
+
+
+
+	/**
+	 * remove the cgroups of clients which were not updated
+	 */
+	void endUpdate()
+	{
+		std::map<int, SClientCgroup>::iterator iter = client_cgroups.begin();
+		while (iter != client_cgroups.end())
+		{
+			if (iter->second.active)
+			{
+				iter++;
+				continue;
+			}
+
+			std::string path = getClientPath(iter->first);
+
+			// lift the restriction for processes which are still running
+			writeFile(path+"/cpuset.cpus", "");
+
+			if (!removeCgroup(path))
+				stale_cgroup_paths.push_back(path);
+
+			client_cgroups.erase(iter++);
+		}
+
+		// retry to remove cgroups of processes which were still running
+		std::list<std::string>::iterator s = stale_cgroup_paths.begin();
+		while (s != stale_cgroup_paths.end())
+		{
+			if (removeCgroup(*s))
+				s = stale_cgroup_paths.erase(s);
+			else
+				s++;
+		}
+	}
+};
+
+
+#endif /* CCGROUPCPUSET_HPP_ */
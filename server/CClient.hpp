@@ -11,6 +11,8 @@
 #include "CResources.hpp"
 #include <list>
 #include <vector>
+#include <limits>
+#include <algorithm>
 
 
 
@@ -47,11 +49,61 @@ public:
 	 */
 	float distribution_hint;
 
+	/**
+	 * time series of the distribution hints of the last invades
+	 */
+	std::vector<float> distribution_hint_history;
+
 	/**
 	 * scalability graph
 	 */
 	std::vector<float> hint_scalability_graph;
 
+	/**
+	 * priority class (higher values are preferred)
+	 */
+	int priority_class;
+
+	/**
+	 * weight of scalability within priority class
+	 */
+	float weight;
+
+	/**
+	 * group of coupled clients progressing at the pace of the slowest one (0: no group)
+	 */
+	int group_id;
+
+	/**
+	 * deadline: remaining work in seconds on a single core at deadline_timestamp (<= 0: no deadline)
+	 */
+	float deadline_remaining_work;
+
+	/**
+	 * deadline: server time of the last update of the remaining work
+	 */
+	double deadline_timestamp;
+
+	/**
+	 * deadline: server time by which the remaining work should be finished (< 0: as early as possible)
+	 */
+	double deadline;
+
+	/**
+	 * client lent all cores except the first one (see CPMO::lend())
+	 */
+	bool lending_active;
+
+	/**
+	 * cores lent by the client which are preferred when cores are assigned to the client again
+	 */
+	std::list<int> lent_cores;
+
+	/**
+	 * number of cores before lending which are guaranteed until they are returned (0: nothing to return)
+	 */
+	int lend_return_cores;
+
 	/**
 	 * retreat triggered?
 	 */
@@ -72,6 +124,26 @@ public:
 	 */
 	std::list<int> assigned_cores;
 
+	/**
+	 * hardware performance counters: instructions per cycle
+	 */
+	float perf_ipc;
+
+	/**
+	 * hardware performance counters: last level cache misses per 1000 instructions
+	 */
+	float perf_llc_mpki;
+
+	/**
+	 * hardware performance counters: estimated memory bandwidth in bytes per second
+	 */
+	float perf_memory_bandwidth;
+
+	/**
+	 * hardware performance counters: client is classified as memory bound
+	 */
+	bool perf_memory_bound;
+
 
 
 	/**
@@ -80,7 +152,8 @@ public:
 	CClient(
 			pid_t i_pid,			///< process id of client application
 			int i_client_id,		///< unique client id
-			int i_verbosity_level
+			int i_verbosity_level,
+			int i_group_id = 0		///< group of coupled clients (0: no group)
 	)	:
 		verbosity_level(i_verbosity_level),
 		pid(i_pid),
@@ -88,9 +161,21 @@ public:
 		constraint_min_cores(0),
 		constraint_max_cores(0),
 		distribution_hint(0),
+		priority_class(0),
+		weight(1.0f),
+		group_id(i_group_id),
+		deadline_remaining_work(0),
+		deadline_timestamp(0),
+		deadline(-1),
+		lending_active(false),
+		lend_return_cores(0),
 		retreat_active(false),
 		reinvade_nonblocking_active(false),
-		number_of_assigned_cores(0)
+		number_of_assigned_cores(0),
+		perf_ipc(0),
+		perf_llc_mpki(0),
+		perf_memory_bandwidth(0),
+		perf_memory_bound(false)
 	{
 	}
 
@@ -174,7 +259,7 @@ public:
 				exit(-1);
 			}
 
-			cResources.core_pids[core_id] = 0;
+			cResources.releaseCore(core_id);
 			number_of_assigned_cores--;
 
 			if (verbosity_level > 5)
@@ -218,6 +303,76 @@ public:
 
 
 
+	/**
+	 * append a distribution hint to its time series
+	 */
+	void recordDistributionHint(
+			float i_distribution_hint,
+			int i_max_history
+	)
+	{
+		distribution_hint_history.push_back(i_distribution_hint);
+
+		if ((int)distribution_hint_history.size() > i_max_history)
+			distribution_hint_history.erase(distribution_hint_history.begin());
+	}
+
+
+
+	/**
+	 * return the weighted scalability which is used as the objective for the optimization
+	 *
+	 * the priority class is not included since the classes are optimized lexicographically
+	 */
+	float getWeightedScalability(
+			int i_sampling_point	// sampling point is given in cpu nrs. starting at 1!!!
+	)
+	{
+		return weight*getScalability(i_sampling_point);
+	}
+
+
+
+	/**
+	 * return the remaining work of the deadline at a given server time
+	 *
+	 * the progress since the last update is estimated with the scalability
+	 * of the currently assigned cores
+	 */
+	double getDeadlineRemainingWork(
+			double i_timestamp		///< server time
+	)
+	{
+		double w = deadline_remaining_work;
+
+		if (number_of_assigned_cores > 0 && i_timestamp > deadline_timestamp)
+			w -= (i_timestamp - deadline_timestamp)*getScalability(number_of_assigned_cores);
+
+		return std::max(w, 0.0);
+	}
+
+
+
+	/**
+	 * return the predicted time to finish the remaining work with a given number of cores
+	 */
+	double getPredictedFinishTime(
+			double i_remaining_work,	///< remaining work in seconds on a single core
+			int i_sampling_point		///< number of cores
+	)
+	{
+		if (i_remaining_work <= 0)
+			return 0;
+
+		float s = getScalability(i_sampling_point);
+		if (s <= 0)
+			return std::numeric_limits<double>::max();
+
+		return i_remaining_work/(double)s;
+	}
+
+
+
 	/**
 	 * update the scalability graph for a given client
 	 */
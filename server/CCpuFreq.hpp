@@ -0,0 +1,312 @@
+/*
+ * CCpuFreq.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Model of the core frequency depending on the number of active cores.
+ *
+ * With turbo frequencies, the frequency of each core drops with the number
+ * of active cores. This class estimates the relative frequency
+ * (current frequency / maximum frequency) for a given number of active cores.
+ *
+ * The initial estimate is derived from the maximum and base frequency (if
+ * provided by the cpufreq driver) or from the energy performance bias. The
+ * estimate is then refined online by sampling scaling_cur_freq of the active
+ * cores.
+ *
+ * All information is read relative to a sysfs root directory which can be
+ * replaced by a mock directory tree with the same layout:
+ *
+ *   [root]/cpu[N]/cpufreq/scaling_cur_freq
+ *   [root]/cpu[N]/cpufreq/cpuinfo_max_freq
+ *   [root]/cpu[N]/cpufreq/base_frequency		(optional)
+ *   [root]/cpu[N]/power/energy_perf_bias		(optional)
+ */
+
+#ifndef CCPUFREQ_HPP_
+#define CCPUFREQ_HPP_
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+
+class CCpuFreq
+{
+	/**
+	 * root directory of cpu information in sysfs
+	 */
+	std::string sysfs_cpu_path;
+
+	/**
+	 * number of cores
+	 */
+	int num_cores;
+
+	/**
+	 * physical cpu id of each core
+	 */
+	std::vector<int> cpu_ids;
+
+	/**
+	 * maximum frequency for each core in kHz
+	 */
+	std::vector<double> max_freq;
+
+	/**
+	 * energy performance bias (0: performance, 15: energy saving) for each core
+	 */
+	std::vector<int> energy_perf_bias;
+
+	/**
+	 * estimated relative frequency if all cores are active
+	 */
+	double all_core_relative_freq;
+
+	/**
+	 * sampled relative frequencies: decayed sum and weight for each number of active cores (index: #active_cores-1)
+	 */
+	std::vector<double> sampled_sum;
+	std::vector<double> sampled_weight;
+
+	/**
+	 * relative frequency for each number of active cores (index: #active_cores-1)
+	 */
+	std::vector<double> relative_freq;
+
+	int verbosity_level;
+
+
+
+	/**
+	 * read a single value from a sysfs file
+	 */
+	bool readValue(
+			int i_core_id,				///< core id (index in cpu_ids)
+			const char *i_file,
+			double &o_value
+	)
+	{
+		std::ostringstream filename;
+		filename << sysfs_cpu_path << "/cpu" << cpu_ids[i_core_id] << "/" << i_file;
+
+		std::ifstream f(filename.str().c_str());
+		if (!f.is_open())
+			return false;
+
+		f >> o_value;
+		return !f.fail();
+	}
+
+
+
+	/**
+	 * recompute the relative frequencies from the model and the samples
+	 */
+	void updateModel()
+	{
+		relative_freq.resize(num_cores);
+
+		for (int n = 1; n <= num_cores; n++)
+		{
+			// linear model between single core turbo and all-core frequency
+			double model = 1.0;
+			if (num_cores > 1)
+				model = 1.0 - (1.0-all_core_relative_freq)*(double)(n-1)/(double)(num_cores-1);
+
+			double w = sampled_weight[n-1];
+			if (w > 0)
+			{
+				// blend model with sampled frequencies
+				double sampled = sampled_sum[n-1]/w;
+				double a = std::min(w/5.0, 1.0);
+				relative_freq[n-1] = model*(1.0-a) + sampled*a;
+			}
+			else
+			{
+				relative_freq[n-1] = model;
+			}
+		}
+
+		// the frequency never increases with the number of active cores
+		for (int n = 1; n < num_cores; n++)
+			if (relative_freq[n] > relative_freq[n-1])
+				relative_freq[n] = relative_freq[n-1];
+	}
+
+
+
+public:
+	CCpuFreq()	:
+		sysfs_cpu_path("/sys/devices/system/cpu"),
+		num_cores(0),
+		all_core_relative_freq(1.0),
+		verbosity_level(0)
+	{
+	}
+
+
+
+	/**
+	 * read the frequency information from sysfs
+	 *
+	 * \return false if no frequency information is available
+	 */
+	bool setup(
+			const std::vector<int> &i_cpu_ids,	///< physical cpu id of each core
+			const char *i_sysfs_cpu_path,		///< root directory of cpu information
+			int i_verbosity_level
+	)
+	{
+		cpu_ids = i_cpu_ids;
+		num_cores = cpu_ids.size();
+		sysfs_cpu_path = i_sysfs_cpu_path;
+		verbosity_level = i_verbosity_level;
+
+		max_freq.assign(num_cores, 0);
+		energy_perf_bias.assign(num_cores, 6);
+		sampled_sum.assign(num_cores, 0);
+		sampled_weight.assign(num_cores, 0);
+
+		bool freq_available = false;
+		double sum_base_ratio = 0;
+		int num_base_ratio = 0;
+		double sum_epb = 0;
+		int num_epb = 0;
+
+		for (int i = 0; i < num_cores; i++)
+		{
+			double value;
+
+			if (readValue(i, "cpufreq/cpuinfo_max_freq", value) && value > 0)
+			{
+				max_freq[i] = value;
+				freq_available = true;
+
+				double base;
+				if (readValue(i, "cpufreq/base_frequency", base) && base > 0)
+				{
+					sum_base_ratio += std::min(base/value, 1.0);
+					num_base_ratio++;
+				}
+			}
+
+			if (readValue(i, "power/energy_perf_bias", value))
+			{
+				energy_perf_bias[i] = (int)value;
+				sum_epb += value;
+				num_epb++;
+			}
+		}
+
+		if (!freq_available)
+		{
+			if (verbosity_level > 1)
+				std::cout << "No cpufreq information available in " << sysfs_cpu_path << std::endl;
+
+			num_cores = 0;
+			return false;
+		}
+
+		if (num_base_ratio > 0)
+		{
+			// all cores active => approximately base frequency
+			all_core_relative_freq = sum_base_ratio/(double)num_base_ratio;
+		}
+		else
+		{
+			// heuristic: performance biased systems use a larger turbo range
+			double epb = (num_epb > 0 ? sum_epb/(double)num_epb : 6.0);
+			all_core_relative_freq = 0.75 + 0.15*epb/15.0;
+		}
+
+		updateModel();
+
+		if (verbosity_level > 1)
+		{
+			std::cout << "cpufreq model: relative all-core frequency " << all_core_relative_freq << std::endl;
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * sample the current frequencies of all active cores
+	 */
+	void sample(
+			const pid_t *i_core_pids	///< pids assigned to cores, 0 for idle cores
+	)
+	{
+		if (num_cores == 0)
+			return;
+
+		int num_active_cores = 0;
+		double sum_relative_freq = 0;
+		int num_relative_freq = 0;
+
+		for (int i = 0; i < num_cores; i++)
+		{
+			if (i_core_pids[i] <= 0)
+				continue;
+
+			num_active_cores++;
+
+			double cur_freq;
+			if (max_freq[i] <= 0 || !readValue(i, "cpufreq/scaling_cur_freq", cur_freq))
+				continue;
+
+			sum_relative_freq += std::min(cur_freq/max_freq[i], 1.0);
+			num_relative_freq++;
+		}
+
+		if (num_relative_freq == 0)
+			return;
+
+		int n = num_active_cores-1;
+		sampled_sum[n] = sampled_sum[n]*0.9 + sum_relative_freq/(double)num_relative_freq;
+		sampled_weight[n] = sampled_weight[n]*0.9 + 1.0;
+
+		updateModel();
+	}
+
+
+
+	/**
+	 * return true if the frequency model is available
+	 */
+	bool isAvailable()
+	{
+		return num_cores > 0;
+	}
+
+
+
+	/**
+	 * return the estimated relative frequency for the given number of active cores
+	 */
+	double getFrequencyFactor(
+			int i_num_active_cores
+	)
+	{
+		if (num_cores == 0 || i_num_active_cores <= 0)
+			return 1.0;
+
+		if (i_num_active_cores > num_cores)
+			i_num_active_cores = num_cores;
+
+		return relative_freq[i_num_active_cores-1];
+	}
+};
+
+
+#endif /* CCPUFREQ_HPP_ */
@@ -0,0 +1,927 @@
+/*
+ * CGlobalOptimizer.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Solvers for the distribution of cores among clients.
+ *
+ * Each client c is assigned a number of cores n in [lower[c], upper[c]]
+ * and contributes values[c][n] to the objective. The sum of the values,
+ * optionally scaled by a frequency factor depending on the total number of
+ * active cores, is maximized.
+ *
+ * Two solvers are available:
+ *
+ *  - greedy: iteratively assigns a single core to the client with the largest
+ *    improvement. This is optimal for concave scalability graphs only and gets
+ *    stuck at plateaus or jumps (e.g. power-of-two sweet spots).
+ *
+ *  - dynamic programming: solves the multiple-choice knapsack problem over
+ *    clients x cores exactly with O(#clients * #cores^2) work.
+ *
+ * In auto mode, the dynamic programming solver is used for problem sizes which
+ * are expected to fit into its time budget. If the dynamic programming solver
+ * exceeds its time budget, the greedy solution is used.
+ *
+ * Clients in different priority classes are optimized lexicographically, see
+ * solvePriorityClasses().
+ *
+ * Coupled clients (e.g. the MPI ranks of a single job) are assigned to a
+ * group. A group progresses at the pace of its slowest member, hence it
+ * contributes the minimum progress values[c][n]/work[c] of its members times
+ * the sum of their work to the objective. Before solving, each group is
+ * replaced by a single unit whose value for a given number of cores is
+ * computed by assigning the cores one by one to the slowest member. The
+ * cores of a unit are distributed back to the members afterwards.
+ *
+ * For large problems, both solvers can be executed in parallel with a small
+ * number of OpenMP threads: the candidate improvements of the greedy solver
+ * are reduced in parallel in each iteration and the rows of the dynamic
+ * programming table are computed in parallel. These threads can be pinned
+ * to cpus which are not assigned to clients.
+ */
+
+#ifndef CGLOBALOPTIMIZER_HPP_
+#define CGLOBALOPTIMIZER_HPP_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <omp.h>
+
+#include "../include/CStopwatch.hpp"
+
+
+
+class CGlobalOptimizer
+{
+public:
+	enum EOptimizer
+	{
+		OPTIMIZER_AUTO = 0,
+		OPTIMIZER_GREEDY = 1,
+		OPTIMIZER_DP = 2
+	};
+
+
+	/**
+	 * solver to use
+	 */
+	EOptimizer optimizer;
+
+	/**
+	 * problem size (#clients * #cores^2) the dynamic programming solver
+	 * processes per second with a single thread
+	 *
+	 * in auto mode, the dynamic programming solver is only used if the
+	 * problem is expected to be solved within the time budget
+	 */
+	double dp_problem_size_per_second;
+
+	/**
+	 * time budget in seconds for the dynamic programming solver
+	 */
+	double dp_time_budget;
+
+
+	/**
+	 * number of threads for the parallel solvers (1: serial solvers only)
+	 */
+	int num_threads;
+
+	/**
+	 * minimum number of clients to use the parallel solvers
+	 */
+	int parallel_min_clients;
+
+	/**
+	 * minimum number of cores to use the parallel solvers
+	 */
+	int parallel_min_cores;
+
+	/**
+	 * cpus to pin the threads of the parallel solvers to (empty: no pinning)
+	 */
+	std::vector<int> thread_cpu_ids;
+
+
+	/**
+	 * total number of cores
+	 */
+	int num_cores;
+
+	/**
+	 * minimum number of cores for each client
+	 */
+	std::vector<int> lower;
+
+	/**
+	 * maximum number of cores for each client
+	 */
+	std::vector<int> upper;
+
+	/**
+	 * objective value of each client for a given number of cores (index: #cores)
+	 *
+	 * only the values in [lower, upper] are used
+	 */
+	std::vector<std::vector<double> > values;
+
+	/**
+	 * priority class of each client (higher classes are optimized first)
+	 */
+	std::vector<int> priority_class;
+
+	/**
+	 * relative frequency for a given number of active cores (index: #cores)
+	 *
+	 * if empty, the frequency is assumed to be independent of the number of active cores
+	 */
+	std::vector<double> frequency_factor;
+
+	/**
+	 * group id of each client (-1: not coupled to other clients)
+	 */
+	std::vector<int> groups;
+
+	/**
+	 * work of each client to compute the progress values[c][n]/work[c] of coupled clients
+	 */
+	std::vector<double> work;
+
+
+	/**
+	 * true if the last solution was computed by the dynamic programming solver
+	 */
+	bool last_solution_dp;
+
+	/**
+	 * true if the last solution was computed by a parallel solver
+	 */
+	bool last_solution_parallel;
+
+	/**
+	 * time in seconds to compute the last solution
+	 */
+	double last_solution_seconds;
+
+	/**
+	 * objective of the last solution
+	 */
+	double last_solution_objective;
+
+
+private:
+	/**
+	 * storage for the dynamic programming tables
+	 */
+	std::vector<double> dp_prev;
+	std::vector<double> dp_next;
+	std::vector<int> dp_choice;
+
+	/**
+	 * maximum improvement found by each thread of the parallel greedy solver
+	 */
+	std::vector<double> thread_max_improvement;
+	std::vector<int> thread_max_improvement_client;
+
+	/**
+	 * true if the threads are already pinned to thread_cpu_ids
+	 */
+	bool threads_pinned;
+
+	/**
+	 * coupled groups replaced by a single unit: clients of each unit and the
+	 * member which gets the next core for each core above the lower bound
+	 */
+	std::vector<std::vector<int> > unit_members;
+	std::vector<std::vector<int> > unit_increments;
+
+	/**
+	 * problem of the clients while the problem of the units is solved
+	 */
+	std::vector<int> client_lower;
+	std::vector<int> client_upper;
+	std::vector<std::vector<double> > client_values;
+
+
+
+	double getFrequencyFactor(
+			int i_num_cores
+	)
+	{
+		if (frequency_factor.empty())
+			return 1.0;
+
+		if (i_num_cores >= (int)frequency_factor.size())
+			return frequency_factor.back();
+
+		return frequency_factor[i_num_cores];
+	}
+
+
+
+	/**
+	 * pin the threads of the parallel solvers
+	 *
+	 * the OpenMP runtime reuses the threads of the team,
+	 * therefore this is only done once.
+	 * The calling thread (the thread of the world scheduler) is
+	 * part of the team and keeps its affinity.
+	 */
+	void pinThreads()
+	{
+		if (threads_pinned || thread_cpu_ids.empty())
+			return;
+
+		threads_pinned = true;
+
+#pragma omp parallel num_threads(num_threads)
+		if (omp_get_thread_num() > 0)
+		{
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+
+			for (size_t i = 0; i < thread_cpu_ids.size(); i++)
+				CPU_SET(thread_cpu_ids[i], &cpu_set);
+
+			if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0)
+				perror("pthread_setaffinity_np");
+		}
+	}
+
+
+
+	/**
+	 * replace each coupled group by a single unit
+	 *
+	 * \return false if there are no groups with more than a single client
+	 */
+	bool setupUnits()
+	{
+		int num_clients = values.size();
+
+		unit_members.clear();
+		unit_increments.clear();
+
+		bool coupled = false;
+		std::vector<int> group_unit;
+		std::vector<int> group_ids;
+
+		for (int c = 0; c < num_clients; c++)
+		{
+			if (groups.empty() || groups[c] < 0)
+			{
+				unit_members.push_back(std::vector<int>(1, c));
+				continue;
+			}
+
+			size_t g = std::find(group_ids.begin(), group_ids.end(), groups[c]) - group_ids.begin();
+
+			if (g == group_ids.size())
+			{
+				group_ids.push_back(groups[c]);
+				group_unit.push_back(unit_members.size());
+				unit_members.push_back(std::vector<int>());
+			}
+			else
+			{
+				coupled = true;
+			}
+
+			unit_members[group_unit[g]].push_back(c);
+		}
+
+		if (!coupled)
+			return false;
+
+		client_lower.swap(lower);
+		client_upper.swap(upper);
+		client_values.swap(values);
+
+		int num_units = unit_members.size();
+
+		lower.resize(num_units);
+		upper.resize(num_units);
+		values.resize(num_units);
+		unit_increments.resize(num_units);
+
+		for (int u = 0; u < num_units; u++)
+		{
+			const std::vector<int> &m = unit_members[u];
+
+			values[u].assign(num_cores+1, 0);
+
+			if (m.size() == 1)
+			{
+				lower[u] = client_lower[m[0]];
+				upper[u] = client_upper[m[0]];
+				values[u] = client_values[m[0]];
+				continue;
+			}
+
+			std::vector<int> n(m.size());
+			double sum_work = 0;
+
+			lower[u] = 0;
+			for (size_t i = 0; i < m.size(); i++)
+			{
+				n[i] = client_lower[m[i]];
+				lower[u] += n[i];
+				sum_work += getWork(m[i]);
+			}
+
+			int cores = lower[u];
+
+			while (true)
+			{
+				// slowest member
+				double min_progress = std::numeric_limits<double>::infinity();
+				int slowest = -1;
+
+				for (size_t i = 0; i < m.size(); i++)
+				{
+					double p = client_values[m[i]][n[i]]/getWork(m[i]);
+
+					// prefer members which can get more cores for equal progress
+					if (p < min_progress || (p == min_progress && slowest >= 0 && n[slowest] >= client_upper[m[slowest]]))
+					{
+						min_progress = p;
+						slowest = i;
+					}
+				}
+
+				if (cores <= num_cores)
+					values[u][cores] = min_progress*sum_work;
+
+				// additional cores can't speed up the group
+				if (cores >= num_cores || n[slowest] >= client_upper[m[slowest]])
+					break;
+
+				n[slowest]++;
+				cores++;
+				unit_increments[u].push_back(slowest);
+			}
+
+			upper[u] = std::min(cores, num_cores);
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * distribute the cores of the units to their members and restore the problem of the clients
+	 */
+	void expandUnits(
+			std::vector<int> &io_distribution
+	)
+	{
+		lower.swap(client_lower);
+		upper.swap(client_upper);
+		values.swap(client_values);
+
+		std::vector<int> unit_distribution;
+		unit_distribution.swap(io_distribution);
+
+		io_distribution.resize(values.size());
+
+		for (size_t u = 0; u < unit_members.size(); u++)
+		{
+			const std::vector<int> &m = unit_members[u];
+
+			if (m.size() == 1)
+			{
+				io_distribution[m[0]] = unit_distribution[u];
+				continue;
+			}
+
+			for (size_t i = 0; i < m.size(); i++)
+				io_distribution[m[i]] = lower[m[i]];
+
+			int additional_cores = unit_distribution[u];
+			for (size_t i = 0; i < m.size(); i++)
+				additional_cores -= lower[m[i]];
+
+			for (int i = 0; i < additional_cores; i++)
+				io_distribution[m[unit_increments[u][i]]]++;
+		}
+	}
+
+
+
+	double getWork(
+			int i_client
+	)
+	{
+		if (work.empty() || work[i_client] <= 0)
+			return 1.0;
+
+		return work[i_client];
+	}
+
+
+
+public:
+	CGlobalOptimizer()	:
+		optimizer(OPTIMIZER_AUTO),
+		dp_problem_size_per_second(800.0*1000.0*1000.0),
+		dp_time_budget(0.01),
+		num_threads(1),
+		parallel_min_clients(32),
+		parallel_min_cores(64),
+		num_cores(0),
+		last_solution_dp(false),
+		last_solution_parallel(false),
+		last_solution_seconds(0),
+		last_solution_objective(0),
+		threads_pinned(false)
+	{
+	}
+
+
+
+	/**
+	 * setup problem for given number of clients and cores
+	 */
+	void resize(
+			int i_num_clients,
+			int i_num_cores
+	)
+	{
+		num_cores = i_num_cores;
+
+		lower.assign(i_num_clients, 1);
+		upper.assign(i_num_clients, 1);
+		priority_class.assign(i_num_clients, 0);
+
+		values.resize(i_num_clients);
+		for (int c = 0; c < i_num_clients; c++)
+			values[c].assign(i_num_cores+1, 0);
+
+		frequency_factor.clear();
+
+		groups.assign(i_num_clients, -1);
+		work.assign(i_num_clients, 1.0);
+	}
+
+
+
+	/**
+	 * return the objective for a given distribution
+	 *
+	 * coupled groups contribute the minimum progress of their members
+	 */
+	double computeObjective(
+			const std::vector<int> &i_distribution
+	)
+	{
+		double s = 0;
+		int used_cores = 0;
+
+		std::vector<int> group_ids;
+		std::vector<double> group_min_progress;
+		std::vector<double> group_sum_work;
+
+		for (size_t c = 0; c < values.size(); c++)
+		{
+			used_cores += i_distribution[c];
+
+			if (groups.empty() || groups[c] < 0)
+			{
+				s += values[c][i_distribution[c]];
+				continue;
+			}
+
+			size_t g = std::find(group_ids.begin(), group_ids.end(), groups[c]) - group_ids.begin();
+
+			if (g == group_ids.size())
+			{
+				group_ids.push_back(groups[c]);
+				group_min_progress.push_back(std::numeric_limits<double>::infinity());
+				group_sum_work.push_back(0);
+			}
+
+			group_min_progress[g] = std::min(group_min_progress[g], values[c][i_distribution[c]]/getWork(c));
+			group_sum_work[g] += getWork(c);
+		}
+
+		for (size_t g = 0; g < group_ids.size(); g++)
+			s += group_min_progress[g]*group_sum_work[g];
+
+		return s*getFrequencyFactor(used_cores);
+	}
+
+
+
+	/**
+	 * return true if the problem size is large enough for the parallel solvers
+	 */
+	bool useParallelSolvers()
+	{
+		return	num_threads > 1 &&
+				(int)values.size() >= parallel_min_clients &&
+				num_cores >= parallel_min_cores;
+	}
+
+
+
+	/**
+	 * greedy search starting at the lower bounds
+	 */
+	void solveGreedy(
+			std::vector<int> &o_distribution
+	)
+	{
+		int num_clients = values.size();
+
+		o_distribution.resize(num_clients);
+
+		int used_cores = 0;
+		double current_value = 0;
+
+		for (int c = 0; c < num_clients; c++)
+		{
+			o_distribution[c] = lower[c];
+			used_cores += lower[c];
+			current_value += values[c][lower[c]];
+		}
+
+		for (; used_cores < num_cores; used_cores++)
+		{
+			double max_improvement = -1;
+			int max_improvement_client = -1;
+
+			for (int c = 0; c < num_clients; c++)
+			{
+				int n = o_distribution[c];
+
+				if (n >= upper[c])
+					continue;
+
+				// the objective is separable => only the modified client has to be evaluated
+				double diff = values[c][n+1] - values[c][n];
+
+				if (diff > max_improvement)
+				{
+					max_improvement = diff;
+					max_improvement_client = c;
+				}
+			}
+
+			if (max_improvement_client == -1)
+				break;
+
+			double next_value = current_value + max_improvement;
+
+			/*
+			 * each additional active core reduces the frequency of all active cores
+			 * => stop if the frequency drop outweighs the improved objective
+			 */
+			if (!frequency_factor.empty())
+			{
+				if (next_value*getFrequencyFactor(used_cores+1) <= current_value*getFrequencyFactor(used_cores))
+					break;
+			}
+
+			o_distribution[max_improvement_client]++;
+			current_value = next_value;
+		}
+	}
+
+
+
+	/**
+	 * greedy search with the candidate improvements reduced in parallel
+	 *
+	 * this computes the same distribution as solveGreedy()
+	 */
+	void solveGreedyParallel(
+			std::vector<int> &o_distribution
+	)
+	{
+		int num_clients = values.size();
+
+		o_distribution.resize(num_clients);
+
+		int used_cores = 0;
+		double current_value = 0;
+
+		for (int c = 0; c < num_clients; c++)
+		{
+			o_distribution[c] = lower[c];
+			used_cores += lower[c];
+			current_value += values[c][lower[c]];
+		}
+
+		thread_max_improvement.resize(num_threads);
+		thread_max_improvement_client.resize(num_threads);
+
+		bool done = (used_cores >= num_cores);
+
+#pragma omp parallel num_threads(num_threads) if(!done)
+		{
+			int thread_id = omp_get_thread_num();
+
+			while (!done)
+			{
+				double max_improvement = -1;
+				int max_improvement_client = -1;
+
+				// contiguous chunks => same order as the serial search
+#pragma omp for schedule(static) nowait
+				for (int c = 0; c < num_clients; c++)
+				{
+					int n = o_distribution[c];
+
+					if (n >= upper[c])
+						continue;
+
+					double diff = values[c][n+1] - values[c][n];
+
+					if (diff > max_improvement)
+					{
+						max_improvement = diff;
+						max_improvement_client = c;
+					}
+				}
+
+				thread_max_improvement[thread_id] = max_improvement;
+				thread_max_improvement_client[thread_id] = max_improvement_client;
+
+#pragma omp barrier
+
+#pragma omp single
+				{
+					max_improvement = -1;
+					max_improvement_client = -1;
+
+					for (int t = 0; t < omp_get_num_threads(); t++)
+					{
+						if (thread_max_improvement[t] > max_improvement)
+						{
+							max_improvement = thread_max_improvement[t];
+							max_improvement_client = thread_max_improvement_client[t];
+						}
+					}
+
+					if (max_improvement_client == -1)
+					{
+						done = true;
+					}
+					else
+					{
+						double next_value = current_value + max_improvement;
+
+						if (	!frequency_factor.empty() &&
+								next_value*getFrequencyFactor(used_cores+1) <= current_value*getFrequencyFactor(used_cores)
+						)
+						{
+							done = true;
+						}
+						else
+						{
+							o_distribution[max_improvement_client]++;
+							current_value = next_value;
+
+							used_cores++;
+							if (used_cores >= num_cores)
+								done = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+
+
+	/**
+	 * exact solution by dynamic programming over clients x cores
+	 *
+	 * \return false if the time budget was exceeded
+	 */
+	bool solveDP(
+			std::vector<int> &o_distribution,
+			double i_time_budget = -1,	///< time budget in seconds, no limit if negative
+			bool i_parallel = false		///< compute the rows of the table in parallel
+	)
+	{
+		CStopwatch cStopwatch;
+		cStopwatch.start();
+
+		int num_clients = values.size();
+		int N = num_cores;
+
+		const double invalid = -std::numeric_limits<double>::infinity();
+
+		/*
+		 * dp_prev[u]: best objective for the clients processed so far using exactly u cores
+		 */
+		dp_prev.assign(N+1, invalid);
+		dp_next.resize(N+1);
+		dp_choice.resize((size_t)num_clients*(size_t)(N+1));
+
+		dp_prev[0] = 0;
+
+		for (int c = 0; c < num_clients; c++)
+		{
+			const std::vector<double> &v = values[c];
+			int *choice = &dp_choice[(size_t)c*(size_t)(N+1)];
+
+			// the work increases with u => interleave the iterations among the threads
+#pragma omp parallel for num_threads(num_threads) schedule(static, 16) if(i_parallel)
+			for (int u = 0; u <= N; u++)
+			{
+				double best = invalid;
+				int best_n = -1;
+
+				int max_n = std::min(upper[c], u);
+				for (int n = lower[c]; n <= max_n; n++)
+				{
+					double p = dp_prev[u-n];
+					if (p == invalid)
+						continue;
+
+					double s = p + v[n];
+
+					// prefer more cores for equal objectives
+					if (s >= best)
+					{
+						best = s;
+						best_n = n;
+					}
+				}
+
+				dp_next[u] = best;
+				choice[u] = best_n;
+			}
+
+			dp_prev.swap(dp_next);
+
+			if (i_time_budget >= 0 && cStopwatch.getTimeSinceStart() > i_time_budget)
+				return false;
+		}
+
+		/*
+		 * search for the best total number of active cores
+		 */
+		double best = invalid;
+		int best_u = -1;
+		for (int u = 0; u <= N; u++)
+		{
+			if (dp_prev[u] == invalid)
+				continue;
+
+			double s = dp_prev[u]*getFrequencyFactor(u);
+
+			if (s >= best)
+			{
+				best = s;
+				best_u = u;
+			}
+		}
+
+		// infeasible lower bounds
+		if (best_u == -1)
+			return false;
+
+		/*
+		 * backtracking
+		 */
+		o_distribution.resize(num_clients);
+
+		int u = best_u;
+		for (int c = num_clients-1; c >= 0; c--)
+		{
+			int n = dp_choice[(size_t)c*(size_t)(N+1)+u];
+			assert(n >= 0);
+
+			o_distribution[c] = n;
+			u -= n;
+		}
+
+		return true;
+	}
+
+
+
+	/**
+	 * compute the distribution with the configured solver
+	 */
+	void solve(
+			std::vector<int> &o_distribution
+	)
+	{
+		CStopwatch cStopwatch;
+		cStopwatch.start();
+
+		bool coupled = setupUnits();
+
+		last_solution_dp = false;
+		last_solution_parallel = useParallelSolvers();
+
+		if (last_solution_parallel)
+			pinThreads();
+
+		double problem_size = (double)values.size()*(double)num_cores*(double)num_cores;
+
+		if (	optimizer == OPTIMIZER_DP ||
+				(optimizer == OPTIMIZER_AUTO && problem_size <= dp_problem_size_per_second*dp_time_budget*(last_solution_parallel ? num_threads : 1))
+		)
+		{
+			last_solution_dp = solveDP(o_distribution, optimizer == OPTIMIZER_DP ? -1 : dp_time_budget, last_solution_parallel);
+		}
+
+		if (!last_solution_dp)
+		{
+			if (last_solution_parallel)
+				solveGreedyParallel(o_distribution);
+			else
+				solveGreedy(o_distribution);
+		}
+
+		if (coupled)
+			expandUnits(o_distribution);
+
+		last_solution_seconds = cStopwatch.getTimeSinceStart();
+		last_solution_objective = computeObjective(o_distribution);
+	}
+
+
+
+	/**
+	 * compute the distribution lexicographically over the priority classes
+	 *
+	 * the clients of the highest priority class are optimized first while all
+	 * other clients are kept at their lower bounds. their number of cores is
+	 * then fixed for the optimization of the next lower priority class.
+	 */
+	void solvePriorityClasses(
+			std::vector<int> &o_distribution
+	)
+	{
+		int num_clients = values.size();
+
+		std::vector<int> classes(priority_class);
+		std::sort(classes.begin(), classes.end());
+		classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+
+		if (classes.size() <= 1)
+		{
+			solve(o_distribution);
+			return;
+		}
+
+		CStopwatch cStopwatch;
+		cStopwatch.start();
+
+		std::vector<int> class_lower(lower);
+		std::vector<int> class_upper(upper);
+
+		o_distribution = lower;
+
+		bool all_dp = true;
+
+		for (int k = classes.size()-1; k >= 0; k--)
+		{
+			for (int c = 0; c < num_clients; c++)
+			{
+				if (priority_class[c] == classes[k])
+				{
+					lower[c] = class_lower[c];
+					upper[c] = class_upper[c];
+				}
+				else if (priority_class[c] > classes[k])
+				{
+					lower[c] = o_distribution[c];
+					upper[c] = o_distribution[c];
+				}
+				else
+				{
+					lower[c] = class_lower[c];
+					upper[c] = class_lower[c];
+				}
+			}
+
+			solve(o_distribution);
+			all_dp = all_dp && last_solution_dp;
+		}
+
+		lower.swap(class_lower);
+		upper.swap(class_upper);
+
+		last_solution_dp = all_dp;
+		last_solution_seconds = cStopwatch.getTimeSinceStart();
+	}
+};
+
+
+#endif /* CGLOBALOPTIMIZER_HPP_ */
@@ -27,12 +27,15 @@ public:
 
 	CCommonData *cCommonData;
 
+	CResources *cResources;
+
 	/**
 	 * outgoing messages
 	 */
 	CMessages_Outgoing()	:
 		cMessageQueueServer(0),
-		cCommonData(0)
+		cCommonData(0),
+		cResources(0)
 	{
 
 	}
@@ -40,11 +43,13 @@ public:
 
 	void setup(
 			CMessageQueueServer *i_cMessageQueueServer,
-			CCommonData *i_cCommonData
+			CCommonData *i_cCommonData,
+			CResources *i_cResources
 	)
 	{
 		cMessageQueueServer = i_cMessageQueueServer;
 		cCommonData = i_cCommonData;
+		cResources = i_cResources;
 	}
 
 
@@ -94,6 +99,32 @@ public:
 
 
 
+	/**
+	 * send position in the admission queue
+	 */
+	void msg_outgoing_invadeQueued(
+			pid_t i_client_pid,
+			int i_position,
+			int i_queue_length
+	)
+	{
+		SPMOMessage &m = *(SPMOMessage*)(cMessageQueueServer->msg_data_load_ptr);
+
+		m.package_type = SPMOMessage::SERVER_INVADE_QUEUED;
+		m.data.invade_queued.pid = i_client_pid;
+		m.data.invade_queued.position = i_position;
+		m.data.invade_queued.queue_length = i_queue_length;
+		m.data.invade_queued.seq_id = cCommonData->seq_id++;
+
+		cMessageQueueServer->sendToClient(
+				(size_t)&(m.data) - (size_t)&m +
+				sizeof(m.data.invade_queued),
+				i_client_pid
+			);
+	}
+
+
+
 	/**
 	 * send invade answer
 	 */
@@ -116,7 +147,8 @@ public:
 			int i = 0;
 			for (std::list<int>::iterator iter = i_cClient->assigned_cores.begin(); iter != i_cClient->assigned_cores.end(); iter++)
 			{
-				m.data.invade_answer.affinity_array[i] = *iter;
+				// clients only get physical cpu ids
+				m.data.invade_answer.affinity_array[i] = cResources->getPhysicalCpuId(*iter);
 				i++;
 			}
 
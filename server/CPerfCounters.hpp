@@ -0,0 +1,282 @@
+/*
+ * CPerfCounters.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Per-core hardware performance counters (cycles, instructions, last level
+ * cache misses) based on perf_event_open.
+ *
+ * The counters are opened system-wide for each core. Since the world scheduler
+ * knows which client is running on which core, the samples can be accumulated
+ * for each client afterwards.
+ *
+ * Opening system-wide counters requires a sufficiently low
+ * /proc/sys/kernel/perf_event_paranoid value or CAP_PERFMON. If the counters
+ * are not available (e.g. in containers), isAvailable() returns false and
+ * sampling is a no-op.
+ */
+
+#ifndef CPERFCOUNTERS_HPP_
+#define CPERFCOUNTERS_HPP_
+
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+
+
+
+/**
+ * sample of performance counters for a single core
+ */
+struct SPerfCounterSample
+{
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t llc_misses;
+};
+
+
+
+class CPerfCounters
+{
+	/**
+	 * counters opened for a single core
+	 */
+	struct SCoreCounters
+	{
+		int fd_group_leader;	///< cycles, group leader
+		int fd_instructions;	///< instructions
+		int fd_llc_misses;		///< last level cache misses
+
+		SPerfCounterSample last;	///< last values read from the counters
+	};
+
+	std::vector<SCoreCounters> core_counters;
+
+	bool available;
+
+	int verbosity_level;
+
+
+
+	static int perf_event_open(
+			struct perf_event_attr *i_attr,
+			pid_t i_pid,
+			int i_cpu,
+			int i_group_fd,
+			unsigned long i_flags
+	)
+	{
+		return (int)syscall(__NR_perf_event_open, i_attr, i_pid, i_cpu, i_group_fd, i_flags);
+	}
+
+
+
+	static int openCounter(
+			uint32_t i_type,
+			uint64_t i_config,
+			int i_cpu,
+			int i_group_fd
+	)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+
+		attr.size = sizeof(attr);
+		attr.type = i_type;
+		attr.config = i_config;
+		attr.disabled = (i_group_fd == -1);
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		return perf_event_open(&attr, -1, i_cpu, i_group_fd, 0);
+	}
+
+
+
+	void closeAll()
+	{
+		for (size_t i = 0; i < core_counters.size(); i++)
+		{
+			SCoreCounters &c = core_counters[i];
+
+			if (c.fd_llc_misses >= 0)
+				close(c.fd_llc_misses);
+
+			if (c.fd_instructions >= 0)
+				close(c.fd_instructions);
+
+			if (c.fd_group_leader >= 0)
+				close(c.fd_group_leader);
+		}
+
+		core_counters.clear();
+		available = false;
+	}
+
+
+
+	/**
+	 * read the current counter values of a core
+	 */
+	bool readCore(
+			SCoreCounters &c,
+			SPerfCounterSample &o_sample
+	)
+	{
+		// nr, time_enabled, time_running, values[3]
+		uint64_t data[3+3];
+
+		ssize_t s = read(c.fd_group_leader, data, sizeof(data));
+
+		if (s < (ssize_t)(sizeof(uint64_t)*3) || data[0] != 3)
+			return false;
+
+		// scale values in case that counters were multiplexed
+		double scale = 1.0;
+		if (data[2] > 0 && data[2] < data[1])
+			scale = (double)data[1]/(double)data[2];
+
+		o_sample.cycles = (uint64_t)((double)data[3]*scale);
+		o_sample.instructions = (uint64_t)((double)data[4]*scale);
+		o_sample.llc_misses = (uint64_t)((double)data[5]*scale);
+
+		return true;
+	}
+
+
+
+public:
+	CPerfCounters()	:
+		available(false),
+		verbosity_level(0)
+	{
+	}
+
+
+
+	~CPerfCounters()
+	{
+		closeAll();
+	}
+
+
+
+	/**
+	 * open counters for the given cpus
+	 *
+	 * \return true if counters are available
+	 */
+	bool setup(
+			const std::vector<int> &i_cpu_ids,	///< cpu ids to open counters for
+			int i_verbosity_level
+	)
+	{
+		closeAll();
+
+		verbosity_level = i_verbosity_level;
+
+		SCoreCounters closed_counters;
+		memset(&closed_counters, 0, sizeof(closed_counters));
+		closed_counters.fd_group_leader = -1;
+		closed_counters.fd_instructions = -1;
+		closed_counters.fd_llc_misses = -1;
+
+		core_counters.resize(i_cpu_ids.size(), closed_counters);
+
+		for (size_t i = 0; i < i_cpu_ids.size(); i++)
+		{
+			SCoreCounters &c = core_counters[i];
+
+			c.fd_group_leader = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, i_cpu_ids[i], -1);
+
+			if (c.fd_group_leader >= 0)
+			{
+				c.fd_instructions = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, i_cpu_ids[i], c.fd_group_leader);
+				c.fd_llc_misses = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, i_cpu_ids[i], c.fd_group_leader);
+			}
+
+			if (c.fd_group_leader < 0 || c.fd_instructions < 0 || c.fd_llc_misses < 0)
+			{
+				if (verbosity_level > 1)
+				{
+					std::cout << "Hardware performance counters not available for cpu " << i_cpu_ids[i] << " (";
+					std::cout << strerror(errno) << ") => deactivating performance counters" << std::endl;
+				}
+
+				closeAll();
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < core_counters.size(); i++)
+		{
+			SCoreCounters &c = core_counters[i];
+
+			ioctl(c.fd_group_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(c.fd_group_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+			readCore(c, c.last);
+		}
+
+		available = true;
+		return true;
+	}
+
+
+
+	/**
+	 * return true if performance counters are available
+	 */
+	bool isAvailable()
+	{
+		return available;
+	}
+
+
+
+	/**
+	 * sample the counter increments of all cores since the last call
+	 *
+	 * \return false if counters are not available
+	 */
+	bool sample(
+			std::vector<SPerfCounterSample> &o_samples	///< output: counter increments for each core
+	)
+	{
+		if (!available)
+			return false;
+
+		o_samples.resize(core_counters.size());
+
+		for (size_t i = 0; i < core_counters.size(); i++)
+		{
+			SCoreCounters &c = core_counters[i];
+
+			SPerfCounterSample s;
+			if (!readCore(c, s))
+			{
+				memset(&o_samples[i], 0, sizeof(SPerfCounterSample));
+				continue;
+			}
+
+			o_samples[i].cycles = s.cycles - c.last.cycles;
+			o_samples[i].instructions = s.instructions - c.last.instructions;
+			o_samples[i].llc_misses = s.llc_misses - c.last.llc_misses;
+
+			c.last = s;
+		}
+
+		return true;
+	}
+};
+
+
+#endif /* CPERFCOUNTERS_HPP_ */
@@ -10,11 +10,24 @@
 
 #include <list>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../include/CNumaTopology.hpp"
 
 
 
 /**
  * this class provides a container for the resources
+ *
+ * the cores managed by the world scheduler are enumerated by logical core ids
+ * 0..max_cores-1. Each logical core is mapped to a physical cpu id from the set
+ * of cpus this process is allowed to run on (affinity mask and cgroup cpuset).
+ * Only physical cpu ids are exchanged with the clients.
  */
 class CResources
 {
@@ -26,13 +39,125 @@ public:
 	 */
 	int max_cores;
 
+	/**
+	 * number of cores which can be assigned to clients
+	 *
+	 * this excludes the cores reserved for the world scheduler
+	 * and cores which are currently not available
+	 */
+	int num_allocatable_cores;
+
 	/**
 	 * pids assigned to one core
 	 *
-	 * when an 0 value is stored to this vector, this CPU resource is free
+	 * when an 0 value is stored to this vector, this CPU resource is free.
+	 * cores reserved for the world scheduler are marked with RESERVED_CORE_PID,
+	 * cores which are not in the allowed cpu set anymore with UNAVAILABLE_CORE_PID.
 	 */
 	pid_t *core_pids;
 
+	/**
+	 * incremented whenever cores may have been freed (wakes up the admission queue)
+	 */
+	unsigned long core_release_events;
+
+	static const pid_t RESERVED_CORE_PID = -1;
+	static const pid_t UNAVAILABLE_CORE_PID = -2;
+
+	/**
+	 * physical cpu id for each logical core id
+	 */
+	std::vector<int> physical_cpu_ids;
+
+	/**
+	 * cores which are still assigned to a client but are not in the
+	 * allowed cpu set anymore. These cores get unavailable once released.
+	 */
+	std::vector<bool> unavailable_pending;
+
+	/**
+	 * cpus this process is allowed to run on
+	 */
+	std::vector<int> allowed_cpu_ids;
+
+
+
+	/**
+	 * cpus of the affinity mask of this process recorded at startup
+	 *
+	 * sched_getaffinity() returns the mask of the calling thread which
+	 * changes once the world scheduler or the optimizer threads are pinned,
+	 * hence the mask is only read before any thread is pinned.
+	 */
+	std::vector<int> process_cpu_ids;
+
+
+
+	/**
+	 * discover the cpus of the affinity mask of the calling thread
+	 */
+	static void discoverAffinityCpus(
+			std::vector<int> &o_cpu_ids
+	)
+	{
+		o_cpu_ids.clear();
+
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+
+		if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0)
+		{
+			for (int i = 0; i < CPU_SETSIZE; i++)
+				if (CPU_ISSET(i, &cpu_set))
+					o_cpu_ids.push_back(i);
+		}
+		else
+		{
+			int n = sysconf(_SC_NPROCESSORS_ONLN);
+			for (int i = 0; i < n; i++)
+				o_cpu_ids.push_back(i);
+		}
+	}
+
+
+
+	/**
+	 * restrict the cpus to the effective cpuset of the cgroup (v2) of this process
+	 */
+	static void intersectCgroupCpus(
+			std::vector<int> &io_cpu_ids
+	)
+	{
+		std::vector<int> cgroup_cpu_ids;
+		if (!CNumaTopology::readCgroupCpus(cgroup_cpu_ids))
+			return;
+
+		std::vector<int> cpu_ids;
+		for (size_t i = 0; i < io_cpu_ids.size(); i++)
+			if (std::find(cgroup_cpu_ids.begin(), cgroup_cpu_ids.end(), io_cpu_ids[i]) != cgroup_cpu_ids.end())
+				cpu_ids.push_back(io_cpu_ids[i]);
+
+		if (!cpu_ids.empty())
+			io_cpu_ids.swap(cpu_ids);
+	}
+
+
+
+	/**
+	 * discover the cpus this process is allowed to run on
+	 *
+	 * this is the intersection of the affinity mask of the process
+	 * recorded at startup and the effective cpuset of the cgroup.
+	 */
+	void discoverAllowedCpus(
+			std::vector<int> &o_cpu_ids
+	)
+	{
+		o_cpu_ids = process_cpu_ids;
+		intersectCgroupCpus(o_cpu_ids);
+	}
+
+
 
 	/**
 	 * create new client with corresponding pid
@@ -42,11 +167,16 @@ public:
 			int i_verbose_level = 0
 	) :
 		verbose_level(-1),
-		max_cores(-1)
+		max_cores(-1),
+		num_allocatable_cores(-1),
+		core_release_events(0)
 	{
+		discoverAffinityCpus(process_cpu_ids);
+		discoverAllowedCpus(allowed_cpu_ids);
+
 		// setup maximum number of cores
 		if (i_max_cores == -1)
-			max_cores = sysconf(_SC_NPROCESSORS_ONLN);
+			max_cores = allowed_cpu_ids.size();
 		else
 			max_cores = i_max_cores;
 
@@ -59,6 +189,191 @@ public:
 		// setup cores to be associated with no pid
 		for (int i = 0; i < max_cores; i++)
 			core_pids[i] = 0;
+
+		/*
+		 * map logical cores to the allowed cpus
+		 *
+		 * if more cores than allowed cpus are requested, the allowed cpus are oversubscribed
+		 */
+		physical_cpu_ids.resize(max_cores);
+		for (int i = 0; i < max_cores; i++)
+			physical_cpu_ids[i] = allowed_cpu_ids[i % allowed_cpu_ids.size()];
+
+		unavailable_pending.assign(max_cores, false);
+
+		num_allocatable_cores = max_cores;
+	}
+
+
+
+	/**
+	 * map each logical core to a virtual cpu with the same id
+	 *
+	 * this is used by simulations with more cores than cpus are available
+	 * since the cores are identified by the cpu ids exchanged with the clients
+	 */
+	void setupVirtualCpus()
+	{
+		allowed_cpu_ids.resize(max_cores);
+
+		for (int i = 0; i < max_cores; i++)
+		{
+			allowed_cpu_ids[i] = i;
+			physical_cpu_ids[i] = i;
+		}
+	}
+
+
+
+	/**
+	 * return the physical cpu id of a logical core
+	 */
+	int getPhysicalCpuId(
+			int i_core_id
+	)
+	{
+		assert(i_core_id >= 0 && i_core_id < max_cores);
+		return physical_cpu_ids[i_core_id];
+	}
+
+
+
+	/**
+	 * return the logical core id of a physical cpu id or -1 if this cpu is not managed
+	 */
+	int getLogicalCoreId(
+			int i_cpu_id
+	)
+	{
+		for (int i = 0; i < max_cores; i++)
+			if (physical_cpu_ids[i] == i_cpu_id)
+				return i;
+
+		return -1;
+	}
+
+
+
+	/**
+	 * release a core which was assigned to a client
+	 */
+	void releaseCore(
+			int i_core_id
+	)
+	{
+		if (unavailable_pending[i_core_id])
+		{
+			core_pids[i_core_id] = UNAVAILABLE_CORE_PID;
+			unavailable_pending[i_core_id] = false;
+			return;
+		}
+
+		core_pids[i_core_id] = 0;
+		core_release_events++;
+	}
+
+
+
+	/**
+	 * update the logical cores for a new set of allowed cpus
+	 *
+	 * logical cores keep their physical cpu if it is still allowed.
+	 * cores whose cpu vanished are mapped to newly allowed cpus if available,
+	 * otherwise they get unavailable (immediately if free, once released otherwise).
+	 *
+	 * \return true if anything changed
+	 */
+	bool updateAllowedCpus(
+			const std::vector<int> &i_cpu_ids
+	)
+	{
+		if (i_cpu_ids == allowed_cpu_ids || i_cpu_ids.empty())
+			return false;
+
+		allowed_cpu_ids = i_cpu_ids;
+
+		// allowed cpus which are not mapped so far
+		std::vector<int> fresh_cpu_ids;
+		for (size_t j = 0; j < allowed_cpu_ids.size(); j++)
+			if (std::find(physical_cpu_ids.begin(), physical_cpu_ids.end(), allowed_cpu_ids[j]) == physical_cpu_ids.end())
+				fresh_cpu_ids.push_back(allowed_cpu_ids[j]);
+
+		for (int i = 0; i < max_cores; i++)
+		{
+			if (core_pids[i] == RESERVED_CORE_PID)
+				continue;
+
+			if (std::find(allowed_cpu_ids.begin(), allowed_cpu_ids.end(), physical_cpu_ids[i]) != allowed_cpu_ids.end())
+				continue;
+
+			if (!fresh_cpu_ids.empty())
+			{
+				physical_cpu_ids[i] = fresh_cpu_ids.back();
+				fresh_cpu_ids.pop_back();
+
+				if (core_pids[i] == UNAVAILABLE_CORE_PID)
+				{
+					core_pids[i] = 0;
+					core_release_events++;
+				}
+
+				unavailable_pending[i] = false;
+				continue;
+			}
+
+			if (core_pids[i] == 0)
+			{
+				core_pids[i] = UNAVAILABLE_CORE_PID;
+			}
+			else if (core_pids[i] > 0)
+			{
+				// keep the client running on an allowed cpu until the core is released
+				physical_cpu_ids[i] = allowed_cpu_ids[i % allowed_cpu_ids.size()];
+				unavailable_pending[i] = true;
+			}
+		}
+
+		updateNumberOfAllocatableCores();
+		return true;
+	}
+
+
+
+	/**
+	 * update the number of cores which can be assigned to clients
+	 */
+	void updateNumberOfAllocatableCores()
+	{
+		num_allocatable_cores = 0;
+
+		for (int i = 0; i < max_cores; i++)
+			if (core_pids[i] >= 0 && !unavailable_pending[i])
+				num_allocatable_cores++;
+	}
+
+
+	/**
+	 * reserve cores for the world scheduler
+	 *
+	 * this has to be done before any core is assigned to a client
+	 */
+	void reserveCores(
+			const std::vector<int> &i_core_ids	///< core ids to reserve, ids beyond max_cores are ignored
+	)
+	{
+		for (size_t i = 0; i < i_core_ids.size(); i++)
+		{
+			int core_id = i_core_ids[i];
+
+			if (core_id < 0 || core_id >= max_cores)
+				continue;
+
+			assert(core_pids[core_id] == 0 || core_pids[core_id] == RESERVED_CORE_PID);
+
+			core_pids[core_id] = RESERVED_CORE_PID;
+		}
+
+		updateNumberOfAllocatableCores();
 	}
 
 
@@ -0,0 +1,122 @@
+/*
+ * CSharedResourceMap.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Export of the resource map to a shared memory segment (see SPMOResourceMap)
+ * which can be read by monitoring tools (e.g. ipmo_top) without any
+ * communication with the server.
+ */
+
+#ifndef CSHAREDRESOURCEMAP_HPP_
+#define CSHAREDRESOURCEMAP_HPP_
+
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../include/SPMOResourceMap.hpp"
+
+
+
+class CSharedResourceMap
+{
+	/**
+	 * mapped shared memory segment
+	 */
+	SPMOResourceMap *resource_map;
+
+public:
+	CSharedResourceMap()	:
+		resource_map(nullptr)
+	{
+	}
+
+
+
+	~CSharedResourceMap()
+	{
+		shutdown();
+	}
+
+
+
+	/**
+	 * create shared memory segment
+	 *
+	 * \return false if the segment could not be created
+	 */
+	bool setup(
+			int i_verbosity_level
+	)
+	{
+		// readable for monitoring tools of all users, writable only by the server
+		int fd = shm_open(PMO_RESOURCE_MAP_NAME, O_CREAT | O_RDWR, 0644);
+		if (fd < 0)
+		{
+			if (i_verbosity_level > 1)
+				std::cerr << "shm_open " << PMO_RESOURCE_MAP_NAME << ": " << strerror(errno) << " => resource map not exported" << std::endl;
+			return false;
+		}
+
+		if (ftruncate(fd, sizeof(SPMOResourceMap)) != 0)
+		{
+			perror("ftruncate");
+			close(fd);
+			return false;
+		}
+
+		void *p = mmap(nullptr, sizeof(SPMOResourceMap), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if (p == MAP_FAILED)
+		{
+			perror("mmap");
+			return false;
+		}
+
+		resource_map = (SPMOResourceMap*)p;
+
+		memset((void*)resource_map, 0, sizeof(SPMOResourceMap));
+		resource_map->version = PMO_RESOURCE_MAP_VERSION;
+		resource_map->server_pid = getpid();
+
+		return true;
+	}
+
+
+
+	/**
+	 * remove the shared memory segment
+	 */
+	void shutdown()
+	{
+		if (resource_map == nullptr)
+			return;
+
+		munmap(resource_map, sizeof(SPMOResourceMap));
+		shm_unlink(PMO_RESOURCE_MAP_NAME);
+
+		resource_map = nullptr;
+	}
+
+
+
+	/**
+	 * return the segment to be updated between beginWrite() and endWrite()
+	 * or nullptr if no segment is available
+	 */
+	SPMOResourceMap *getResourceMap()
+	{
+		return resource_map;
+	}
+};
+
+
+#endif /* CSHAREDRESOURCEMAP_HPP_ */
@@ -16,17 +16,28 @@
 #include <cmath>
 #include <signal.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include "../include/CMessageQueueServer.hpp"
 #include "../include/CMessageQueueClient.hpp"
 #include "../include/SPMOMessage.hpp"
 #include "../include/CStopwatch.hpp"
+#include "../include/CNumaTopology.hpp"
+#include "../include/CNotificationSocket.hpp"
 
 #include "CCommonData.hpp"
 #include "CClient.hpp"
 #include "CResources.hpp"
 
 #include "CMessages_Outgoing.hpp"
+#include "CPerfCounters.hpp"
+#include "CCpuFreq.hpp"
+#include "CGlobalOptimizer.hpp"
+#include "CCgroupCpuset.hpp"
+#include "CSharedResourceMap.hpp"
+#include "CAdmissionQueue.hpp"
+#include "CAllocationPredictor.hpp"
 
 
 
@@ -65,9 +76,14 @@ class CWorldScheduler
 
 
 	/**
-	 * delayed setup ACKs
+	 * clients waiting for their first core
 	 */
-	std::list<CClient*> delayed_setup_acks_clients;
+	CAdmissionQueue cAdmissionQueue;
+
+	/**
+	 * precomputed solutions of the global optimization
+	 */
+	CAllocationPredictor cAllocationPredictor;
 
 
 	/**
@@ -75,39 +91,773 @@ class CWorldScheduler
 	 *
 	 * each entry is associated with a client as they are stored in the client list
 	 */
-	std::vector<int> optimal_cpu_distribution;
+	std::vector<int> optimal_cpu_distribution;
+
+	/**
+	 * timer
+	 */
+	CStopwatch cStopwatch;
+
+
+	/**
+	 * outgoing messages
+	 */
+	CMessages_Outgoing cMessages_Outgoing;
+
+
+	/**
+	 * wake up clients after sending asynchronous resource updates
+	 */
+	CNotificationSocket cNotificationSocket;
+
+
+	/**
+	 * NUMA topology
+	 */
+	CNumaTopology cNumaTopology;
+
+
+	/**
+	 * hardware performance counters
+	 */
+	CPerfCounters cPerfCounters;
+
+	/**
+	 * place memory bound clients and compute bound clients on
+	 * NUMA domains based on hardware performance counters
+	 */
+	bool perf_policy_active;
+
+	/**
+	 * minimum time in seconds between two samples of the performance counters
+	 */
+	double perf_sample_interval;
+
+	/**
+	 * timestamp of last sample of the performance counters
+	 */
+	double perf_last_sample_timestamp;
+
+	/**
+	 * clients with more last level cache misses per 1000 instructions are
+	 * classified as memory bound
+	 */
+	float perf_memory_bound_mpki_threshold;
+
+	/**
+	 * storage for samples of the performance counters
+	 */
+	std::vector<SPerfCounterSample> perf_samples;
+
+
+	/**
+	 * model of the core frequency depending on the number of active cores
+	 */
+	CCpuFreq cCpuFreq;
+
+	/**
+	 * include the frequency drop for an increasing number of active cores
+	 * in the objective of the global optimization
+	 */
+	bool cpufreq_policy_active;
+
+	/**
+	 * timestamp of last frequency sample
+	 */
+	double cpufreq_last_sample_timestamp;
+
+
+	/**
+	 * timestamp of last check for changes of the allowed cpu set
+	 */
+	double allowed_cpus_last_check_timestamp;
+
+
+	/**
+	 * solver for the global optimization
+	 */
+	CGlobalOptimizer cGlobalOptimizer;
+
+
+	/**
+	 * cpus reserved for the world scheduler
+	 */
+	std::vector<int> reserved_cpu_ids;
+
+
+	/**
+	 * enforcement of the core distribution with cgroup cpusets
+	 */
+	CCgroupCpuset cCgroupCpuset;
+
+	/**
+	 * enforce the core distribution with cgroup cpusets
+	 */
+	bool cgroup_policy_active;
+
+
+	/**
+	 * resource map exported to shared memory for monitoring tools
+	 */
+	CSharedResourceMap cSharedResourceMap;
+
+
+	/**
+	 * the messages are exchanged with simulated clients (see simulator/)
+	 *
+	 * the cores are mapped to virtual cpus and the time is set by the simulator
+	 */
+	bool simulation_mode;
+
+	/**
+	 * virtual time of the simulation in seconds
+	 */
+	double virtual_timestamp;
+
+
+
+public:
+	/**
+	 * setup world scheduler with given number of cores
+	 */
+	CWorldScheduler(
+			int i_max_cores = -1,		///< initialize system with max-cores
+			int i_verbose_level = 2,	///< verbosity level
+			bool i_color_mode = false,	///< use colored output
+			CMessageQueueServer *i_cMessageQueueSimulation = nullptr	///< message queue of a simulation replacing the system message queue
+	)	:
+		cCommonData(i_verbose_level, i_color_mode),
+		cResources(i_max_cores, i_verbose_level),
+		client_enumerator_id(1),
+		perf_policy_active(false),
+		perf_sample_interval(0.1),
+		perf_last_sample_timestamp(0),
+		perf_memory_bound_mpki_threshold(10.0f),
+		cpufreq_policy_active(false),
+		cpufreq_last_sample_timestamp(0),
+		allowed_cpus_last_check_timestamp(0),
+		cgroup_policy_active(false),
+		simulation_mode(i_cMessageQueueSimulation != nullptr),
+		virtual_timestamp(0)
+	{
+		cStopwatch.start();
+
+		if (simulation_mode)
+		{
+			// no process, shared memory or cpu of this system is involved
+			cMessageQueueServer = i_cMessageQueueSimulation;
+
+			cResources.setupVirtualCpus();
+
+			cMessages_Outgoing.setup(cMessageQueueServer, &cCommonData, &cResources);
+			return;
+		}
+
+		cMessageQueueServer = new CMessageQueueServer(cCommonData.verbosity_level);
+
+		cMessages_Outgoing.setup(cMessageQueueServer, &cCommonData, &cResources);
+
+		cNotificationSocket.setupSender();
+
+		cSharedResourceMap.setup(cCommonData.verbosity_level);
+	}
+
+
+
+	/**
+	 * return the current time in seconds since the start of the world scheduler
+	 */
+	double getTimestamp()
+	{
+		if (simulation_mode)
+			return virtual_timestamp;
+
+		return cStopwatch.getTimeSinceStart();
+	}
+
+
+
+	/**
+	 * set the virtual time of a simulation
+	 */
+	void setVirtualTimestamp(
+			double i_timestamp
+	)
+	{
+		assert(simulation_mode);
+		virtual_timestamp = i_timestamp;
+	}
+
+
+
+	/**
+	 * activate precomputed solutions of the global optimization for predicted distribution hints
+	 */
+	void setupPrediction(
+			int i_max_plans = 16		///< maximum number of precomputed solutions
+	)
+	{
+		cAllocationPredictor.active = true;
+		cAllocationPredictor.max_plans = std::max(i_max_plans, 1);
+	}
+
+
+
+	/**
+	 * setup the solver for the global optimization
+	 */
+	void setupOptimizer(
+			CGlobalOptimizer::EOptimizer i_optimizer,	///< solver to use
+			double i_dp_time_budget						///< time budget in seconds for the dynamic programming solver
+	)
+	{
+		cGlobalOptimizer.optimizer = i_optimizer;
+		cGlobalOptimizer.dp_time_budget = i_dp_time_budget;
+	}
+
+
+
+	/**
+	 * reserve cpus for the world scheduler
+	 *
+	 * the reserved cpus are never assigned to clients.
+	 * this has to be executed before the first client is accepted.
+	 */
+	void setupReservedCores(
+			const char *i_cpu_list,			///< cpus in kernel format (e.g. "0" or "0,32")
+			bool i_reserve_smt_siblings		///< additionally reserve the SMT siblings of these cpus
+	)
+	{
+		std::vector<int> cpu_ids;
+		CNumaTopology::parseCpuList(i_cpu_list, cpu_ids);
+
+		reserved_cpu_ids.clear();
+
+		for (size_t i = 0; i < cpu_ids.size(); i++)
+		{
+			std::vector<int> siblings;
+
+			if (i_reserve_smt_siblings)
+				CNumaTopology::getSMTSiblings(cpu_ids[i], siblings);
+			else
+				siblings.push_back(cpu_ids[i]);
+
+			for (size_t j = 0; j < siblings.size(); j++)
+				if (std::find(reserved_cpu_ids.begin(), reserved_cpu_ids.end(), siblings[j]) == reserved_cpu_ids.end())
+					reserved_cpu_ids.push_back(siblings[j]);
+		}
+
+		std::vector<int> reserved_core_ids;
+		for (size_t i = 0; i < reserved_cpu_ids.size(); i++)
+			reserved_core_ids.push_back(cResources.getLogicalCoreId(reserved_cpu_ids[i]));
+
+		cResources.reserveCores(reserved_core_ids);
+
+		if (cResources.num_allocatable_cores <= 0)
+		{
+			std::cerr << "No cores left for clients after reserving cpus for the world scheduler" << std::endl;
+			exit(-1);
+		}
+
+		if (cCommonData.verbosity_level > 1)
+		{
+			std::cout << "reserved cpus for world scheduler: ";
+			printVec(reserved_cpu_ids);
+			std::cout << "(" << cResources.num_allocatable_cores << " cores left for clients)" << std::endl;
+		}
+	}
+
+
+
+	/**
+	 * pin the calling thread to the reserved cpus and optionally
+	 * run it with a real-time priority
+	 *
+	 * this avoids that the world scheduler is descheduled by the clients
+	 *
+	 * \return false if the thread could not be pinned or the priority could not be set
+	 */
+	bool pinSchedulerThread(
+			int i_realtime_priority		///< SCHED_FIFO priority, 0 to keep the default scheduling policy
+	)
+	{
+		bool ok = true;
+
+		if (!reserved_cpu_ids.empty())
+		{
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+
+			for (size_t i = 0; i < reserved_cpu_ids.size(); i++)
+				CPU_SET(reserved_cpu_ids[i], &cpu_set);
+
+			if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0)
+			{
+				perror("pthread_setaffinity_np");
+				ok = false;
+			}
+		}
+
+		if (i_realtime_priority > 0)
+		{
+			struct sched_param param;
+			param.sched_priority = i_realtime_priority;
+
+			int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+			if (err != 0)
+			{
+				std::cerr << "pthread_setschedparam: " << strerror(err) << " => keeping default scheduling policy" << std::endl;
+				ok = false;
+			}
+		}
+
+		return ok;
+	}
+
+
+
+	/**
+	 * activate the enforcement of the core distribution with cgroup cpusets
+	 *
+	 * \return false if the cgroup base directory is not available
+	 */
+	bool setupCgroupCpuset(
+			const char *i_base_path		///< base directory of the client cgroups
+	)
+	{
+		cgroup_policy_active = cCgroupCpuset.setup(i_base_path, cCommonData.verbosity_level);
+
+		if (cgroup_policy_active && cCommonData.verbosity_level > 1)
+			std::cout << "enforcing core distribution with cgroup cpusets in " << i_base_path << std::endl;
+
+		return cgroup_policy_active;
+	}
+
+
+
+	/**
+	 * export the current resource distribution to the shared memory segment
+	 */
+	void exportResourceMap()
+	{
+		SPMOResourceMap *r = cSharedResourceMap.getResourceMap();
+		if (r == nullptr)
+			return;
+
+		r->beginWrite();
+
+		r->timestamp = getTimestamp();
+
+		r->max_cores = std::min(cResources.max_cores, PMO_RESOURCE_MAP_MAX_CORES);
+		r->num_allocatable_cores = cResources.num_allocatable_cores;
+
+		for (int i = 0; i < r->max_cores; i++)
+		{
+			r->core_pids[i] = cResources.core_pids[i];
+			r->physical_cpu_ids[i] = cResources.physical_cpu_ids[i];
+		}
+
+		r->optimizer_dp = cGlobalOptimizer.last_solution_dp;
+		r->optimizer_seconds = cGlobalOptimizer.last_solution_seconds;
+		r->optimizer_objective = cGlobalOptimizer.last_solution_objective;
+
+		int i = 0;
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end() && i < PMO_RESOURCE_MAP_MAX_CLIENTS; iter++)
+		{
+			CClient &c = *iter;
+			SPMOResourceMapClient &rc = r->clients[i];
+
+			rc.client_id = c.client_id;
+			rc.pid = c.pid;
+			rc.constraint_min_cores = c.constraint_min_cores;
+			rc.constraint_max_cores = c.constraint_max_cores;
+			rc.priority_class = c.priority_class;
+			rc.weight = c.weight;
+			rc.number_of_assigned_cores = c.number_of_assigned_cores;
+			rc.optimal_cores = (i < (int)optimal_cpu_distribution.size() ? optimal_cpu_distribution[i] : 0);
+			rc.scalability_assigned = (rc.number_of_assigned_cores > 0 ? c.getScalability(rc.number_of_assigned_cores) : 0);
+			rc.scalability_optimal = (rc.optimal_cores > 0 ? c.getScalability(rc.optimal_cores) : 0);
+
+			i++;
+		}
+		r->num_clients = i;
+
+		r->endWrite();
+	}
+
+
+
+	/**
+	 * update the cgroup cpuset of a single client
+	 *
+	 * this has to be executed before new cores are sent to the client
+	 * since the client pins its threads to these cores
+	 */
+	void updateCgroupCpuset(
+			CClient *i_cClient
+	)
+	{
+		if (!cgroup_policy_active)
+			return;
+
+		std::list<int> cpu_ids;
+		for (std::list<int>::iterator iter = i_cClient->assigned_cores.begin(); iter != i_cClient->assigned_cores.end(); iter++)
+			cpu_ids.push_back(cResources.getPhysicalCpuId(*iter));
+
+		cCgroupCpuset.updateClient(i_cClient->client_id, i_cClient->pid, cpu_ids);
+	}
+
+
+
+	/**
+	 * update the cgroup cpusets of all clients and remove the cgroups of finished clients
+	 */
+	void flushCgroupCpusets()
+	{
+		if (!cgroup_policy_active)
+			return;
+
+		cCgroupCpuset.beginUpdate();
+
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+			updateCgroupCpuset(&*iter);
+
+		cCgroupCpuset.endUpdate();
+	}
+
+
+
+	/**
+	 * setup threads for the parallel solvers of the global optimization
+	 *
+	 * if no cpus are given, the threads are pinned to the cpus reserved for the
+	 * world scheduler or to the cpus which are not managed by the world scheduler
+	 */
+	void setupOptimizerThreads(
+			int i_num_threads,			///< number of threads, 1 to deactivate parallel solvers
+			const char *i_cpu_list		///< cpus for threads in kernel format (e.g. "8-11") or nullptr
+	)
+	{
+		cGlobalOptimizer.num_threads = std::max(i_num_threads, 1);
+		cGlobalOptimizer.thread_cpu_ids.clear();
+
+		if (cGlobalOptimizer.num_threads == 1)
+			return;
+
+		if (i_cpu_list != nullptr)
+		{
+			std::vector<int> cpu_ids;
+			CNumaTopology::parseCpuList(i_cpu_list, cpu_ids);
+
+			// cpus of cores which are assigned to clients are rejected
+			for (size_t i = 0; i < cpu_ids.size(); i++)
+			{
+				bool managed = false;
+				for (int core_id = 0; core_id < cResources.max_cores; core_id++)
+					if (cResources.physical_cpu_ids[core_id] == cpu_ids[i] && cResources.core_pids[core_id] != CResources::RESERVED_CORE_PID)
+						managed = true;
+
+				if (managed)
+				{
+					std::cerr << "cpu " << cpu_ids[i] << " is managed by the world scheduler => not used for the optimizer threads" << std::endl;
+					continue;
+				}
+
+				cGlobalOptimizer.thread_cpu_ids.push_back(cpu_ids[i]);
+			}
+		}
+		else if (!reserved_cpu_ids.empty())
+		{
+			cGlobalOptimizer.thread_cpu_ids = reserved_cpu_ids;
+		}
+		else
+		{
+			for (size_t i = 0; i < cResources.allowed_cpu_ids.size(); i++)
+				if (cResources.getLogicalCoreId(cResources.allowed_cpu_ids[i]) == -1)
+					cGlobalOptimizer.thread_cpu_ids.push_back(cResources.allowed_cpu_ids[i]);
+		}
+
+		/*
+		 * unpinned threads would compete with the clients for their cores
+		 */
+		if (cGlobalOptimizer.thread_cpu_ids.empty())
+		{
+			std::cerr << "no free cpus for the optimizer threads => parallel global optimization deactivated" << std::endl;
+			cGlobalOptimizer.num_threads = 1;
+			return;
+		}
+
+		// at most a single thread per cpu
+		cGlobalOptimizer.num_threads = std::min(cGlobalOptimizer.num_threads, (int)cGlobalOptimizer.thread_cpu_ids.size());
+
+		if (cCommonData.verbosity_level > 1)
+			std::cout << "parallel global optimization with " << cGlobalOptimizer.num_threads << " threads pinned to " << cGlobalOptimizer.thread_cpu_ids.size() << " cpus" << std::endl;
+	}
+
+
+
+	/**
+	 * activate hardware performance counters and the NUMA placement policy
+	 * which co-locates memory bound and compute bound clients
+	 *
+	 * \return false if performance counters are not available
+	 */
+	bool setupPerfCounters(
+			double i_sample_interval = 0.1,				///< minimum time between two samples
+			float i_memory_bound_mpki_threshold = 10.0f	///< LLC misses per 1000 instructions to classify a client as memory bound
+	)
+	{
+		perf_sample_interval = i_sample_interval;
+		perf_memory_bound_mpki_threshold = i_memory_bound_mpki_threshold;
+
+		std::vector<int> cpu_ids(cResources.max_cores);
+		for (int i = 0; i < cResources.max_cores; i++)
+			cpu_ids[i] = cResources.getPhysicalCpuId(i);
+
+		perf_policy_active = cPerfCounters.setup(cpu_ids, cCommonData.verbosity_level);
+
+		if (cCommonData.verbosity_level > 1)
+		{
+			if (perf_policy_active)
+				std::cout << "Hardware performance counters activated (" << cNumaTopology.num_nodes << " NUMA domains)" << std::endl;
+			else
+				std::cout << "Hardware performance counters not available => NUMA placement policy deactivated" << std::endl;
+		}
+
+		perf_last_sample_timestamp = getTimestamp();
+		return perf_policy_active;
+	}
+
+
+
+	/**
+	 * activate the frequency aware allocation
+	 *
+	 * \return false if no frequency information is available
+	 */
+	bool setupCpuFreq(
+			const char *i_sysfs_cpu_path = "/sys/devices/system/cpu"	///< root directory of cpu information (can be a mock directory)
+	)
+	{
+		cpufreq_policy_active = cCpuFreq.setup(cResources.physical_cpu_ids, i_sysfs_cpu_path, cCommonData.verbosity_level);
+
+		if (cCommonData.verbosity_level > 1)
+		{
+			if (cpufreq_policy_active)
+			{
+				std::cout << "Frequency aware allocation activated" << std::endl;
+				std::cout << " + relative frequencies: ";
+				for (int i = 1; i <= cResources.max_cores; i++)
+					std::cout << cCpuFreq.getFrequencyFactor(i) << " ";
+				std::cout << std::endl;
+			}
+			else
+			{
+				std::cout << "Frequency aware allocation not available" << std::endl;
+			}
+		}
+
+		return cpufreq_policy_active;
+	}
+
+
+
+	/**
+	 * sample the core frequencies to refine the frequency model
+	 */
+	void sampleCpuFreq()
+	{
+		double timestamp = getTimestamp();
+
+		if (timestamp - cpufreq_last_sample_timestamp < 0.5)
+			return;
+
+		cpufreq_last_sample_timestamp = timestamp;
+
+		cCpuFreq.sample(cResources.core_pids);
+	}
+
+
 
 	/**
-	 * timer
+	 * check for changes of the allowed cpu set (e.g. cgroup cpuset updates)
+	 * and redistribute the cores if the set changed
 	 */
-	CStopwatch cStopwatch;
+	void checkAllowedCpus()
+	{
+		if (simulation_mode)
+			return;
+
+		double timestamp = getTimestamp();
+
+		if (timestamp - allowed_cpus_last_check_timestamp < 1.0)
+			return;
+
+		allowed_cpus_last_check_timestamp = timestamp;
+
+		std::vector<int> cpu_ids;
+		cResources.discoverAllowedCpus(cpu_ids);
+
+		if (!cResources.updateAllowedCpus(cpu_ids))
+			return;
+
+		if (cCommonData.verbosity_level > 1)
+		{
+			std::cout << "allowed cpu set changed: ";
+			printVec(cpu_ids);
+			std::cout << "(" << cResources.num_allocatable_cores << " cores left for clients)" << std::endl;
+		}
+
+		runGlobalOptimization();
+
+		sendAsyncReinvadeAnswers();
+
+		printCurrentState("allowed_cpus_changed", -1);
+	}
+
 
 
 	/**
-	 * outgoing messages
+	 * sample performance counters and update the per-client statistics
 	 */
-	CMessages_Outgoing cMessages_Outgoing;
+	void samplePerfCounters()
+	{
+		double timestamp = getTimestamp();
+		double delta_time = timestamp - perf_last_sample_timestamp;
+
+		if (delta_time < perf_sample_interval)
+			return;
+
+		perf_last_sample_timestamp = timestamp;
+
+		if (!cPerfCounters.sample(perf_samples))
+			return;
+
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+		{
+			CClient &c = *iter;
+
+			uint64_t cycles = 0, instructions = 0, llc_misses = 0;
+
+			for (std::list<int>::iterator core_iter = c.assigned_cores.begin(); core_iter != c.assigned_cores.end(); core_iter++)
+			{
+				SPerfCounterSample &p = perf_samples[*core_iter];
+
+				cycles += p.cycles;
+				instructions += p.instructions;
+				llc_misses += p.llc_misses;
+			}
+
+			// not enough information to classify client
+			if (instructions == 0 || cycles == 0)
+				continue;
+
+			c.perf_ipc = (float)((double)instructions/(double)cycles);
+			c.perf_llc_mpki = (float)((double)llc_misses*1000.0/(double)instructions);
+			c.perf_memory_bandwidth = (float)((double)llc_misses*64.0/delta_time);
+			c.perf_memory_bound = (c.perf_llc_mpki > perf_memory_bound_mpki_threshold);
+
+			if (cCommonData.verbosity_level > 3)
+			{
+				std::cout << c << ": IPC " << c.perf_ipc << ", LLC MPKI " << c.perf_llc_mpki;
+				std::cout << ", memory bandwidth " << c.perf_memory_bandwidth*(1.0/(1024.0*1024.0)) << " MB/s";
+				std::cout << (c.perf_memory_bound ? " (memory bound)" : " (compute bound)") << std::endl;
+			}
+		}
+	}
 
 
 
-public:
 	/**
-	 * setup world scheduler with given number of cores
+	 * search for a free core which should be assigned to the given client
+	 *
+	 * without an active performance counter policy, the cores are searched
+	 * starting at i_start in direction i_direction.
+	 *
+	 * with the performance counter policy, the NUMA domain is chosen
+	 * to balance the memory bound clients among the NUMA domains.
+	 *
+	 * \return core id or -1 if no free core is available
 	 */
-	CWorldScheduler(
-			int i_max_cores = -1,		///< initialize system with max-cores
-			int i_verbose_level = 2,	///< verbosity level
-			bool i_color_mode = false	///< use colored output
-	)	:
-		cCommonData(i_verbose_level, i_color_mode),
-		cResources(i_max_cores, i_verbose_level),
-		client_enumerator_id(1)
+	int searchFreeCore(
+			CClient *i_cClient,		///< client to search core for
+			int i_start,			///< start searching at this core
+			int i_direction			///< search direction (+1/-1)
+	)
 	{
-		cStopwatch.start();
+		if (!perf_policy_active || cNumaTopology.num_nodes <= 1)
+		{
+			for (int i = i_start; i >= 0 && i < cResources.max_cores; i += i_direction)
+				if (cResources.core_pids[i] == 0)
+					return i;
 
-		cMessageQueueServer = new CMessageQueueServer(cCommonData.verbosity_level);
+			return -1;
+		}
+
+		int num_nodes = cNumaTopology.num_nodes;
+
+		/*
+		 * memory bound cores, free cores and own cores for each NUMA domain
+		 */
+		std::vector<int> memory_bound_cores(num_nodes, 0);
+		std::vector<int> free_cores(num_nodes, 0);
+		std::vector<int> own_cores(num_nodes, 0);
+
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+		{
+			CClient &c = *iter;
+
+			for (std::list<int>::iterator core_iter = c.assigned_cores.begin(); core_iter != c.assigned_cores.end(); core_iter++)
+			{
+				int node = cNumaTopology.getNode(cResources.getPhysicalCpuId(*core_iter));
+
+				if (c.perf_memory_bound)
+					memory_bound_cores[node]++;
+
+				if (&c == i_cClient)
+					own_cores[node]++;
+			}
+		}
+
+		for (int i = 0; i < cResources.max_cores; i++)
+			if (cResources.core_pids[i] == 0)
+				free_cores[cNumaTopology.getNode(cResources.getPhysicalCpuId(i))]++;
+
+		/*
+		 * memory bound clients: prefer NUMA domains with less memory bound cores
+		 * compute bound clients: prefer NUMA domains with more memory bound cores
+		 *
+		 * for equal pressure, prefer NUMA domains with cores already assigned to the client
+		 */
+		int best_node = -1;
+		for (int n = 0; n < num_nodes; n++)
+		{
+			if (free_cores[n] == 0)
+				continue;
+
+			if (best_node == -1)
+			{
+				best_node = n;
+				continue;
+			}
+
+			int d = memory_bound_cores[n] - memory_bound_cores[best_node];
+			if (i_cClient->perf_memory_bound)
+				d = -d;
 
-		cMessages_Outgoing.setup(cMessageQueueServer, &cCommonData);
+			if (d > 0 || (d == 0 && own_cores[n] > own_cores[best_node]))
+				best_node = n;
+		}
+
+		if (best_node == -1)
+			return -1;
+
+		int start = (i_direction > 0 ? 0 : cResources.max_cores-1);
+		for (int i = start; i >= 0 && i < cResources.max_cores; i += i_direction)
+			if (cResources.core_pids[i] == 0 && cNumaTopology.getNode(cResources.getPhysicalCpuId(i)) == best_node)
+				return i;
+
+		return -1;
 	}
 
 
@@ -135,7 +885,9 @@ public:
 	{
 		printClientsShutdownHint();
 
-		delete cMessageQueueServer;
+		// the message queue of a simulation is owned by the simulator
+		if (!simulation_mode)
+			delete cMessageQueueServer;
 
 		signal(SIGABRT, SIG_DFL);
 		signal(SIGTERM, SIG_DFL);
@@ -183,59 +935,105 @@ public:
 	{
 		/**
 		 * send asynchronous invade information
+		 *
+		 * clients in higher priority classes are processed first to
+		 * assign released cores to them before other clients can grab them
 		 */
+		std::vector<std::pair<CClient*, int> > ordered_clients;
+		ordered_clients.reserve(clients.size());
+
 		int a = 0;
 		for (std::list<CClient>::iterator c = clients.begin(); c != clients.end(); c++)
 		{
-			applyNewOptimumForClientAsync(&*c, a, false);
+			ordered_clients.push_back(std::pair<CClient*, int>(&*c, a));
 			a++;
 		}
+
+		std::stable_sort(ordered_clients.begin(), ordered_clients.end(), comparePriorityClass);
+
+		for (size_t i = 0; i < ordered_clients.size(); i++)
+			applyNewOptimumForClientAsync(ordered_clients[i].first, ordered_clients[i].second, false);
+	}
+
+
+
+	/**
+	 * order clients by descending priority class
+	 */
+	static bool comparePriorityClass(
+			const std::pair<CClient*, int> &a,
+			const std::pair<CClient*, int> &b
+	)
+	{
+		return a.first->priority_class > b.first->priority_class;
 	}
 
 
 
 
 	/**
-	 * search for ACKs which have to be send due to an unsuccessful invade
+	 * queue a client whose invade could not be answered since no core was free
+	 * and send its position in the admission queue
 	 */
-	void searchAndSendDelayedACKs()
+	void queueInvade(
+			CClient *i_cClient
+	)
 	{
-		int a = -1;
-		for (std::list<CClient*>::iterator i = delayed_setup_acks_clients.begin(); i != delayed_setup_acks_clients.end(); i++)
-		{
-			a++;
+		int position = cAdmissionQueue.push(i_cClient->pid, i_cClient->priority_class, getTimestamp());
+
+		if (cCommonData.verbosity_level >= 5)
+			std::cout << "QUEUED INVADE (" << i_cClient->pid << ") at position " << position << " => wait until at least one core is released!" << std::endl;
+
+		cMessages_Outgoing.msg_outgoing_invadeQueued(i_cClient->pid, position, cAdmissionQueue.size());
+	}
 
-			CClient *cClient = *i;
 
-			// search for client id
+
+	/**
+	 * admit the clients at the front of the admission queue
+	 *
+	 * this is only done if cores were released since the last call. the
+	 * clients are admitted in the order of the queue until a client doesn't
+	 * get a core.
+	 */
+	void admitQueuedClients()
+	{
+		if (cAdmissionQueue.empty() || cAdmissionQueue.processed_release_events == cResources.core_release_events)
+			return;
+
+		cAdmissionQueue.processed_release_events = cResources.core_release_events;
+
+		while (!cAdmissionQueue.empty())
+		{
 			int clientVecId;
-			CClient *c = searchClient(cClient->pid, &clientVecId);
+			CClient *cClient = searchClient(cAdmissionQueue.front().pid, &clientVecId);
 
-			if (c == 0)
+			if (cClient == 0)
 			{
-				// client was not found and deleted => simply remove from delayed ack client list
-				i = delayed_setup_acks_clients.erase(i);
+				// client was not found and deleted => simply remove from the queue
+				cAdmissionQueue.remove(cAdmissionQueue.front().pid);
 				continue;
 			}
 
 			// search whether there's a new optimum
-			bool anythingChanged = applyNewOptimumForClient(*c, clientVecId);
-
-			if (!anythingChanged)
-				continue;
+			if (!applyNewOptimumForClient(*cClient, clientVecId))
+				return;
 
 			assert(cClient->number_of_assigned_cores != 0);
 
-			i = delayed_setup_acks_clients.erase(i);
+			double wait_time = cAdmissionQueue.popFront(getTimestamp());
 
 			if (cCommonData.verbosity_level > 2)
-				std::cout << "SENDING DELAYED INVADE ACK (" << cClient->pid << ")" << std::endl;
+			{
+				std::cout << "SENDING DELAYED INVADE ACK (" << cClient->pid << ") after " << wait_time << " seconds in the admission queue" << std::endl;
+				std::cout << " + admitted clients: " << cAdmissionQueue.num_admitted << ", average wait time: " << cAdmissionQueue.sum_wait_time/(double)cAdmissionQueue.num_admitted << ", max wait time: " << cAdmissionQueue.max_wait_time << std::endl;
+			}
 
 			validateResources();
 
 			updateResourceDistributionAndSendClientMessage(cClient, true);
 
-			applyNewOptimumForClientAsync(cClient, a, false);
+			applyNewOptimumForClientAsync(cClient, clientVecId, false);
 
 			printCurrentState("delayed ack", cClient->client_id);
 		}
@@ -273,6 +1071,7 @@ public:
 		/*
 		 * send back mapping
 		 */
+		updateCgroupCpuset(i_cClient);
 		cMessages_Outgoing.msg_outgoing_sendInvadeAnswer(i_cClient, i_anythingChanged);
 	}
 
@@ -308,22 +1107,19 @@ public:
 		if (delta_cores > 0)
 		{
 			// try to increase number of assigned cores
-			for (int i = cResources.max_cores-1; i >= 0; i--)
+			for (int i = searchFreeCore(&cClient, cResources.max_cores-1, -1); i >= 0; i = searchFreeCore(&cClient, i-1, -1))
 			{
-				if (cResources.core_pids[i] == 0)
-				{
-					cores_changed = true;
-					cResources.core_pids[i] = cClient.pid;
-					cClient.assigned_cores.push_back(i);
-					cClient.number_of_assigned_cores++;
+				cores_changed = true;
+				cResources.core_pids[i] = cClient.pid;
+				cClient.assigned_cores.push_back(i);
+				cClient.number_of_assigned_cores++;
 
-					if (cCommonData.verbosity_level > 5)
-						std::cout << " > Adding free core " << i << " to clients core list" << std::endl;
+				if (cCommonData.verbosity_level > 5)
+					std::cout << " > Adding free core " << i << " to clients core list" << std::endl;
 
-					delta_cores--;
-					if (delta_cores == 0)
-						break;
-				}
+				delta_cores--;
+				if (delta_cores == 0)
+					break;
 			}
 
 			// sort cores
@@ -372,7 +1168,7 @@ public:
 
 			cores_changed = true;
 			int core_id = *iter;
-			cResources.core_pids[core_id] = 0;
+			cResources.releaseCore(core_id);
 
 			cClient.number_of_assigned_cores--;
 			iter = cClient.assigned_cores.erase(iter);
@@ -444,26 +1240,41 @@ public:
 		 */
 		if (delta_cores > 0 || (i_force_send_async_answer && delta_cores == 0))
 		{
+			// prefer the cores which were lent by the client
+			for (std::list<int>::iterator iter = i_cClient->lent_cores.begin(); iter != i_cClient->lent_cores.end() && delta_cores > 0; iter++)
+			{
+				int i = *iter;
+				if (cResources.core_pids[i] != 0)
+					continue;
+
+				cores_changed = true;
+				cResources.core_pids[i] = i_cClient->pid;
+				i_cClient->assigned_cores.push_back(i);
+				i_cClient->number_of_assigned_cores++;
+
+				if (cCommonData.verbosity_level > 5 )
+					std::cout << " + applyNewOptimumForClientAsync: Adding lent core " << i << " to clients core list" << std::endl;
+
+				delta_cores--;
+			}
+
 			// try to increase number of assigned cores
-			for (int i = 0; i < cResources.max_cores; i++)
+			for (int i = searchFreeCore(i_cClient, 0, 1); i >= 0 && (delta_cores > 0 || !cores_changed); i = searchFreeCore(i_cClient, i+1, 1))
 			{
-				if (cResources.core_pids[i] == 0)
-				{
-					cores_changed = true;
-					cResources.core_pids[i] = i_cClient->pid;
-					i_cClient->assigned_cores.push_back(i);
-					i_cClient->number_of_assigned_cores++;
+				cores_changed = true;
+				cResources.core_pids[i] = i_cClient->pid;
+				i_cClient->assigned_cores.push_back(i);
+				i_cClient->number_of_assigned_cores++;
 
-					if (cCommonData.verbosity_level > 5 )
-						std::cout << " + applyNewOptimumForClientAsync: Adding free core " << i << " to clients core list" << std::endl;
+				if (cCommonData.verbosity_level > 5 )
+					std::cout << " + applyNewOptimumForClientAsync: Adding free core " << i << " to clients core list" << std::endl;
 
-					delta_cores--;
-					if (delta_cores == 0)
-						break;
+				delta_cores--;
+				if (delta_cores == 0)
+					break;
 
-					assert(0 <= i_cClient->assigned_cores.back());
-					assert(i_cClient->assigned_cores.back() < cResources.max_cores);
-				}
+				assert(0 <= i_cClient->assigned_cores.back());
+				assert(i_cClient->assigned_cores.back() < cResources.max_cores);
 			}
 
 			if (!cores_changed && !i_force_send_async_answer)
@@ -478,6 +1289,13 @@ public:
 			if (cores_changed)
 				i_cClient->assigned_cores.sort();
 
+			// all lent cores returned?
+			if (i_cClient->number_of_assigned_cores >= i_cClient->lend_return_cores)
+			{
+				i_cClient->lend_return_cores = 0;
+				i_cClient->lent_cores.clear();
+			}
+
 			validateResources();
 
 
@@ -495,10 +1313,7 @@ public:
 			int i = 0;
 			for (std::list<int>::iterator iter = i_cClient->assigned_cores.begin(); iter != i_cClient->assigned_cores.end(); iter++)
 			{
-				m.data.invade_answer.affinity_array[i] = *iter;
-
-				assert(0 <= m.data.invade_answer.affinity_array[i]);
-				assert(m.data.invade_answer.affinity_array[i] < cResources.max_cores);
+				m.data.invade_answer.affinity_array[i] = cResources.getPhysicalCpuId(*iter);
 
 				i++;
 			}
@@ -514,12 +1329,16 @@ public:
 
 			m.data.invade_answer.seq_id = cCommonData.seq_id++;
 
+			updateCgroupCpuset(i_cClient);
+
 			cMessageQueueServer->sendToClient(
 					(size_t)&(m.data) - (size_t)&m +
 					sizeof(m.data.invade_answer)+
 					sizeof(int)*(i_cClient->number_of_assigned_cores-1),
 					i_cClient->pid);
 
+			cNotificationSocket.notify(i_cClient->pid);
+
 			i_cClient->reinvade_nonblocking_active = true;
 
 			return;
@@ -559,10 +1378,7 @@ public:
 		int i = 0;
 		for (; iter != i_cClient->assigned_cores.end(); iter++)
 		{
-			m.data.invade_answer.affinity_array[i] = *iter;
-
-			assert(0 <= m.data.invade_answer.affinity_array[i]);
-			assert(m.data.invade_answer.affinity_array[i] < cResources.max_cores);
+			m.data.invade_answer.affinity_array[i] = cResources.getPhysicalCpuId(*iter);
 
 			i++;
 		}
@@ -590,6 +1406,8 @@ public:
 				i_cClient->pid
 			);
 
+		cNotificationSocket.notify(i_cClient->pid);
+
 		i_cClient->reinvade_nonblocking_active = true;
 
 		return;
@@ -638,7 +1456,7 @@ public:
 			std::ios_base::fmtflags original_flags = std::cout.flags();
 			std::cout.setf(std::ios_base::left, std::ios_base::adjustfield);
 			std::cout.width(10);
-			std::cout << cStopwatch.getTimeSinceStart();
+			std::cout << getTimestamp();
 			std::cout.flags(original_flags);
 			std::cout << ": [ ";
 
@@ -646,7 +1464,15 @@ public:
 			{
 				int pid = cResources.core_pids[i];
 
-				if (pid == 0)
+				if (pid == CResources::RESERVED_CORE_PID)
+				{
+					std::cout << "S ";
+				}
+				else if (pid == CResources::UNAVAILABLE_CORE_PID)
+				{
+					std::cout << "X ";
+				}
+				else if (pid == 0)
 				{
 					if (cCommonData.color_mode)
 						std::cout << "\033[0;37m";
@@ -682,67 +1508,186 @@ public:
 			if (i_client_id >= 0)
 				std::cout << " (" << i_client_id << ")";
 
-			std::cout << std::endl;
-		}
+			std::cout << std::endl;
+		}
+
+		if (cCommonData.verbosity_level <= -98)
+		{
+			for (std::list<CClient>::iterator i = clients.begin(); i != clients.end(); i++)
+			{
+				CClient &c = *i;
+
+				std::cout << c.number_of_assigned_cores << "\t";
+			}
+			std::cout << std::endl;
+		}
+
+		if (cCommonData.verbosity_level >= 4)
+		{
+			std::cout << "+ Optimal point: ";
+			for (size_t i = 0; i < optimal_cpu_distribution.size(); i++)
+				std::cout << optimal_cpu_distribution[i] << " ";
+			std::cout << std::endl;
+			std::cout << "==========================" << std::endl;
+		}
+	}
+
+
+
+	/**
+	 * compute overall scalability among different clients for given resource distribution
+	 */
+	float computeScalability(
+			std::vector<int> &o_sampling_point
+	)
+	{
+		float scalability = 0;
+
+		int i = 0;
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+		{
+			CClient &c = *iter;
+			scalability += c.getWeightedScalability(o_sampling_point[i]);
+			i++;
+		}
+
+		return scalability;
+	}
+
+
+
+	template <typename T>
+	void printVec(std::vector<T> &i_vec)
+	{
+		for (size_t i = 0; i < i_vec.size(); i++)
+			std::cout << i_vec[i] << ", ";
+	}
+
+
+
+	/**
+	 * restrict the number of cores of clients with a deadline
+	 *
+	 * the predicted finish time of a client with n cores is its remaining
+	 * work divided by its scalability. the latest finish time of all
+	 * deadline clients is minimized by repeatedly assigning cores to the
+	 * client finishing last. the finish time is then relaxed to the earliest
+	 * deadline which can still be met.
+	 *
+	 * each deadline client is fixed to the smallest number of cores reaching
+	 * this finish time. further cores would only increase the wait time at
+	 * the next synchronization point and are left to the other clients.
+	 */
+	void setupDeadlineConstraints()
+	{
+		double timestamp = getTimestamp();
+
+		std::vector<int> deadline_clients;
+		std::vector<CClient*> deadline_client_ptrs;
+		std::vector<double> remaining_work;
+		std::vector<int> cores;
+
+		int free_cores = cResources.num_allocatable_cores;
+
+		int ci = 0;
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++, ci++)
+		{
+			CClient &c = *iter;
+
+			free_cores -= cGlobalOptimizer.lower[ci];
+
+			if (c.deadline_remaining_work <= 0 || c.lending_active)
+				continue;
+
+			deadline_clients.push_back(ci);
+			deadline_client_ptrs.push_back(&c);
+			remaining_work.push_back(c.getDeadlineRemainingWork(timestamp));
+			cores.push_back(cGlobalOptimizer.lower[ci]);
+		}
+
+		if (deadline_clients.empty())
+			return;
+
+		/*
+		 * minimize the latest finish time
+		 */
+		double finish_time = 0;
+		double earliest_deadline = -1;
+
+		while (true)
+		{
+			size_t last = 0;
+			finish_time = -1;
+
+			for (size_t i = 0; i < deadline_clients.size(); i++)
+			{
+				double t = deadline_client_ptrs[i]->getPredictedFinishTime(remaining_work[i], cores[i]);
+				if (t > finish_time)
+				{
+					finish_time = t;
+					last = i;
+				}
+			}
+
+			// smallest number of cores reducing the finish time of the last client
+			CClient &c = *deadline_client_ptrs[last];
+			int upper = cGlobalOptimizer.upper[deadline_clients[last]];
+
+			int n = cores[last]+1;
+			for (; n <= upper; n++)
+				if (c.getPredictedFinishTime(remaining_work[last], n) < finish_time)
+					break;
 
-		if (cCommonData.verbosity_level <= -98)
-		{
-			for (std::list<CClient>::iterator i = clients.begin(); i != clients.end(); i++)
-			{
-				CClient &c = *i;
+			if (n > upper || n-cores[last] > free_cores)
+				break;
 
-				std::cout << c.number_of_assigned_cores << "\t";
-			}
-			std::cout << std::endl;
+			free_cores -= n-cores[last];
+			cores[last] = n;
 		}
 
-		if (cCommonData.verbosity_level >= 4)
+		for (size_t i = 0; i < deadline_clients.size(); i++)
 		{
-			std::cout << "+ Optimal point: ";
-			for (size_t i = 0; i < optimal_cpu_distribution.size(); i++)
-				std::cout << optimal_cpu_distribution[i] << " ";
-			std::cout << std::endl;
-			std::cout << "==========================" << std::endl;
-		}
-	}
+			CClient &c = *deadline_client_ptrs[i];
 
+			if (c.deadline < 0)
+				continue;
 
+			double t = std::max(c.deadline - timestamp, 0.0);
+			if (earliest_deadline < 0 || t < earliest_deadline)
+				earliest_deadline = t;
+		}
 
-	/**
-	 * compute overall scalability among different clients for given resource distribution
-	 */
-	float computeScalability(
-			std::vector<int> &o_sampling_point
-	)
-	{
-		float scalability = 0;
+		if (earliest_deadline > finish_time)
+			finish_time = earliest_deadline;
+		else if (earliest_deadline >= 0 && cCommonData.verbosity_level > 3)
+			std::cout << "deadline can't be met: predicted finish time " << finish_time << "s, deadline " << earliest_deadline << "s" << std::endl;
 
-		int i = 0;
-		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+		/*
+		 * fix each deadline client to the smallest number of cores reaching the finish time
+		 */
+		for (size_t i = 0; i < deadline_clients.size(); i++)
 		{
-			CClient &c = *iter;
-			scalability += c.getScalability(o_sampling_point[i]);
-			i++;
-		}
-
-		return scalability;
-	}
+			CClient &c = *deadline_client_ptrs[i];
+			int k = deadline_clients[i];
 
+			int n = cGlobalOptimizer.lower[k];
+			while (n < cores[i] && c.getPredictedFinishTime(remaining_work[i], n) > finish_time)
+				n++;
 
+			cGlobalOptimizer.lower[k] = n;
+			cGlobalOptimizer.upper[k] = n;
 
-	template <typename T>
-	void printVec(std::vector<T> &i_vec)
-	{
-		for (size_t i = 0; i < i_vec.size(); i++)
-			std::cout << i_vec[i] << ", ";
+			if (cCommonData.verbosity_level > 5)
+				std::cout << c << ": deadline - remaining work " << remaining_work[i] << "s, " << n << " cores, predicted finish time " << c.getPredictedFinishTime(remaining_work[i], n) << "s" << std::endl;
+		}
 	}
 
 
 
 	/**
-	 * search for best global optimum
+	 * setup the problem of the global optimization for the current clients
 	 */
-	void runGlobalOptimization()
+	void setupGlobalOptimization()
 	{
 		int num_clients = clients.size();
 
@@ -756,9 +1701,11 @@ public:
 		float sum_distribution_hint = 0;
 
 		// reserve at least a single core per client
-		int remaining_non_reserved_cores = cResources.max_cores-num_clients;
+		int remaining_non_reserved_cores = cResources.num_allocatable_cores-num_clients;
+
+		std::vector<std::pair<CClient*, int> > ordered_clients;
+		ordered_clients.reserve(num_clients);
 
-		int used_cores = 0;
 		for (std::list<CClient>::iterator i = clients.begin(); i != clients.end(); i++)
 		{
 			CClient &c = *i;
@@ -766,87 +1713,219 @@ public:
 			if (c.distribution_hint > 0)
 				sum_distribution_hint += c.distribution_hint;
 
-			if (c.constraint_min_cores <= 1)
+			optimal_cpu_distribution[a] = 1;
+
+			ordered_clients.push_back(std::pair<CClient*, int>(&c, a));
+			a++;
+		}
+
+		/*
+		 * guarantee the minimum number of cores with clients
+		 * in higher priority classes being served first
+		 */
+		std::stable_sort(ordered_clients.begin(), ordered_clients.end(), comparePriorityClass);
+
+		for (size_t i = 0; i < ordered_clients.size(); i++)
+		{
+			CClient &c = *ordered_clients[i].first;
+
+			if (c.lending_active)
+				continue;
+
+			// cores lent by the client are returned first
+			int min_cores = std::max(c.constraint_min_cores, std::min(c.lend_return_cores, c.constraint_max_cores));
+
+			if (min_cores <= 1)
+				continue;
+
+			int delta = std::min(min_cores-1, remaining_non_reserved_cores);
+			if (delta <= 0)
+				continue;
+
+			optimal_cpu_distribution[ordered_clients[i].second] += delta;
+			remaining_non_reserved_cores -= delta;
+		}
+
+		float inv_sum_distribution_hint = 0;
+		if (sum_distribution_hint > 0)
+			inv_sum_distribution_hint = (float)cResources.num_allocatable_cores/sum_distribution_hint;
+
+		/*
+		 * setup problem for the solver
+		 */
+		cGlobalOptimizer.resize(num_clients, cResources.num_allocatable_cores);
+
+		/*
+		 * no client can get more cores than its lower bound plus the cores which
+		 * are left after all lower bounds are satisfied. Limiting the upper bounds
+		 * avoids setting up values which can't be part of any feasible distribution.
+		 */
+		int free_cores = cResources.num_allocatable_cores;
+		for (int i = 0; i < num_clients; i++)
+			free_cores -= optimal_cpu_distribution[i];
+
+		free_cores = std::max(free_cores, 0);
+
+		int ci = 0;
+		for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+		{
+			CClient &c = *iter;
+
+			int lower = optimal_cpu_distribution[ci];
+			int upper = std::min(c.constraint_max_cores, cResources.num_allocatable_cores);
+
+			if (c.distribution_hint > 0)
+				upper = std::min(upper, (int)std::floor(c.distribution_hint*inv_sum_distribution_hint+0.5f)+1);
+
+			upper = std::min(upper, lower+free_cores);
+			upper = std::max(upper, lower);
+
+			// lending clients only keep their first core
+			if (c.lending_active)
+				upper = lower;
+
+			cGlobalOptimizer.lower[ci] = lower;
+			cGlobalOptimizer.upper[ci] = upper;
+			cGlobalOptimizer.priority_class[ci] = c.priority_class;
+
+			// lending clients are waiting anyway and don't slow down their group
+			if (c.group_id > 0 && !c.lending_active)
 			{
-				optimal_cpu_distribution[a] = 1;
-				remaining_non_reserved_cores--;
-				used_cores++;
+				cGlobalOptimizer.groups[ci] = c.group_id;
+				cGlobalOptimizer.work[ci] = (c.distribution_hint > 0 ? c.distribution_hint : 1.0);
 			}
-			else
+
+			for (int n = lower; n <= upper; n++)
+				cGlobalOptimizer.values[ci][n] = c.getWeightedScalability(n);
+
+			ci++;
+		}
+
+		setupDeadlineConstraints();
+
+		if (cpufreq_policy_active)
+		{
+			cGlobalOptimizer.frequency_factor.resize(cResources.num_allocatable_cores+1);
+
+			for (int n = 0; n <= cResources.num_allocatable_cores; n++)
+				cGlobalOptimizer.frequency_factor[n] = cCpuFreq.getFrequencyFactor(n);
+		}
+	}
+
+
+
+	/**
+	 * search for best global optimum
+	 */
+	void runGlobalOptimization()
+	{
+		CStopwatch cStopwatchOptimization;
+		cStopwatchOptimization.start();
+
+		setupGlobalOptimization();
+
+		if (cAllocationPredictor.active)
+		{
+			if (cAllocationPredictor.lookup(cGlobalOptimizer, optimal_cpu_distribution))
 			{
-				int delta = std::min(c.constraint_min_cores, remaining_non_reserved_cores);
-				assert(delta >= 0);
+				cAllocationPredictor.account(true, cStopwatchOptimization.getTimeSinceStart());
+
+				if (cCommonData.verbosity_level > 5)
+					std::cout << "global optimization: precomputed plan used" << std::endl;
 
-				optimal_cpu_distribution[a] = delta;
-				remaining_non_reserved_cores -= delta;
-				used_cores += delta;
+				return;
 			}
+		}
 
-			a++;
+		cGlobalOptimizer.solvePriorityClasses(optimal_cpu_distribution);
+
+		if (cAllocationPredictor.active)
+		{
+			cAllocationPredictor.store(cGlobalOptimizer, optimal_cpu_distribution);
+			cAllocationPredictor.account(false, cStopwatchOptimization.getTimeSinceStart());
 		}
 
-		float inv_sum_distribution_hint = 0;
-		if (sum_distribution_hint > 0)
-			inv_sum_distribution_hint = (float)cResources.max_cores/sum_distribution_hint;
+		if (cCommonData.verbosity_level > 5)
+		{
+			std::cout << "global optimization (" << (cGlobalOptimizer.last_solution_dp ? "dp" : "greedy");
+			std::cout << (cGlobalOptimizer.last_solution_parallel ? ", parallel" : "") << "): ";
+			std::cout << cGlobalOptimizer.last_solution_seconds << " seconds" << std::endl;
+		}
+	}
 
-		float current_scalability = computeScalability(optimal_cpu_distribution);
 
-#if 0
-		std::cout << "START SEARCH POINT: ";
-		for (int i = 0; i < clients.size(); i++)
-			std::cout << optimal_cpu_distribution[i] << ", ";
-		std::cout << std::endl;
-#endif
+	/**
+	 * precompute the optimum for the predicted next distribution hint of a client
+	 *
+	 * this is executed after the invade was answered. Only a single problem is
+	 * solved per invade, the clients are processed round robin.
+	 */
+	void prestagePredictedOptima()
+	{
+		if (!cAllocationPredictor.active || clients.empty())
+			return;
 
-		/*
-		 * run at max. max_cores iterative searches
-		 */
-		for (; used_cores < cResources.max_cores; used_cores++)
+		int num_clients = clients.size();
+
+		std::list<CClient>::iterator iter = clients.begin();
+		int ci = cAllocationPredictor.next_client % num_clients;
+		std::advance(iter, ci);
+
+		for (int i = 0; i < num_clients; i++)
 		{
-			float max_scalability_improvement = -1;
-			int max_scalability_dir = -1;
+			CClient &c = *iter;
 
-			/**
-			 * search for best scalability
-			 */
-			int ci = 0;
-			for (std::list<CClient>::iterator iter = clients.begin(); iter != clients.end(); iter++)
+			iter++;
+			ci++;
+			if (iter == clients.end())
 			{
-				CClient &c = *iter;
+				iter = clients.begin();
+				ci = 0;
+			}
 
-				if (c.distribution_hint > 0)
-				{
-					if (std::floor(c.distribution_hint*inv_sum_distribution_hint+0.5f) < optimal_cpu_distribution[ci])
-						goto no_more_ressources;
-				}
+			float next_hint;
+			if (!CAllocationPredictor::predictNext(c.distribution_hint_history, next_hint))
+				continue;
 
-				if (c.constraint_max_cores > optimal_cpu_distribution[ci])
-				{
-					optimal_cpu_distribution[ci]++;
-					float next_scalability = computeScalability(optimal_cpu_distribution);
-					optimal_cpu_distribution[ci]--;
+			if (next_hint == c.distribution_hint)
+				continue;
 
-					float diff = next_scalability - current_scalability;
+			cAllocationPredictor.next_client = ci;
 
-					if (diff > max_scalability_improvement)
-					{
-						max_scalability_improvement = diff;
-						max_scalability_dir = ci;
-					}
-				}
+			std::vector<int> current_optimal_cpu_distribution = optimal_cpu_distribution;
 
-			no_more_ressources:
-				ci++;
+			// the statistics of the last solution are exported to the resource map
+			bool last_solution_dp = cGlobalOptimizer.last_solution_dp;
+			bool last_solution_parallel = cGlobalOptimizer.last_solution_parallel;
+			double last_solution_seconds = cGlobalOptimizer.last_solution_seconds;
+			double last_solution_objective = cGlobalOptimizer.last_solution_objective;
+
+			float current_hint = c.distribution_hint;
+			c.distribution_hint = next_hint;
+
+			setupGlobalOptimization();
+
+			std::vector<int> distribution;
+			if (!cAllocationPredictor.lookup(cGlobalOptimizer, distribution))
+			{
+				cGlobalOptimizer.solvePriorityClasses(distribution);
+				cAllocationPredictor.store(cGlobalOptimizer, distribution);
 			}
 
-			if (max_scalability_dir == -1)
-				break;
+			c.distribution_hint = current_hint;
+
+			optimal_cpu_distribution = current_optimal_cpu_distribution;
 
-			optimal_cpu_distribution[max_scalability_dir]++;
+			cGlobalOptimizer.last_solution_dp = last_solution_dp;
+			cGlobalOptimizer.last_solution_parallel = last_solution_parallel;
+			cGlobalOptimizer.last_solution_seconds = last_solution_seconds;
+			cGlobalOptimizer.last_solution_objective = last_solution_objective;
+			return;
 		}
 	}
 
 
+
 	inline void validateResources()
 	{
 #if DEBUG
@@ -892,18 +1971,21 @@ public:
 	 * setup client
 	 */
 	void msg_incoming_clientSetup(
-			pid_t i_pid		///< client pid
+			pid_t i_pid,		///< client pid
+			int i_group_id		///< group of coupled clients (0: no group)
 	)
 	{
 		if (cCommonData.verbosity_level > 1)
 		{
 			std::cout << "CLIENT SETUP: adding client " << i_pid << std::endl;
-			std::cout << " + TIMESTAMP: " << cStopwatch.getTimeSinceStart() << std::endl;
+			if (i_group_id > 0)
+				std::cout << " + GROUP: " << i_group_id << std::endl;
+			std::cout << " + TIMESTAMP: " << getTimestamp() << std::endl;
 		}
 
 		if (clients.empty() && cCommonData.start_time_first_client == 0)
 		{
-			cCommonData.start_time_first_client = cStopwatch.getTimeSinceStart();
+			cCommonData.start_time_first_client = getTimestamp();
 
 			if (cCommonData.verbosity_level > 1)
 			{
@@ -911,7 +1993,7 @@ public:
 			}
 		}
 
-		clients.push_back(CClient(i_pid, client_enumerator_id, cCommonData.verbosity_level));
+		clients.push_back(CClient(i_pid, client_enumerator_id, cCommonData.verbosity_level, i_group_id));
 		client_enumerator_id++;
 
 		if (cCommonData.verbosity_level > 2)
@@ -937,7 +2019,7 @@ public:
 	)
 	{
 		if (cCommonData.verbosity_level > 2)
-			std::cout << cStopwatch.getTimeSinceStart() << " : CLIENT SHUTDOWN (" << i_pid << ")" << std::endl;
+			std::cout << getTimestamp() << " : CLIENT SHUTDOWN (" << i_pid << ")" << std::endl;
 
 		CClient *c = searchClient(i_pid);
 
@@ -950,11 +2032,13 @@ public:
 		c->releaseAllClientCoresAndFreeResources(cResources);
 		int client_id = c->client_id;
 
+		cAdmissionQueue.remove(i_pid);
+
 		cCommonData.sum_client_shutdown_hint += client_shutdown_hint;
 
 		clients.remove(*c);
 
-		double end_time_last_client = cStopwatch.getTimeSinceStart();
+		double end_time_last_client = getTimestamp();
 		double time = end_time_last_client - cCommonData.start_time_first_client;
 
 		cCommonData.sum_client_shutdown_hint_div_time = cCommonData.sum_client_shutdown_hint/time;
@@ -966,6 +2050,9 @@ public:
 				std::cout << "END TIMESTAMP: " << end_time_last_client << std::endl;
 				std::cout << "OVERALL TIME: " << time << std::endl;
 			}
+
+			if (cAllocationPredictor.active && cCommonData.verbosity_level > 1)
+				cAllocationPredictor.printStatistics();
 		}
 
 		printClientsShutdownHint();
@@ -974,7 +2061,7 @@ public:
 
 		runGlobalOptimization();
 
-		searchAndSendDelayedACKs();
+		admitQueuedClients();
 
 		sendAsyncReinvadeAnswers();
 
@@ -998,13 +2085,17 @@ public:
 			int i_min_cores,					///< minimum number of requested cores
 			int i_max_cores,					///< maximum number of requested cores
 			float i_distribution_hint,			///< distribution hint
+			int i_priority_class,				///< priority class
+			float i_weight,						///< weight within priority class
+			float i_remaining_work,				///< remaining work in seconds on a single core (<= 0: no deadline)
+			float i_deadline,					///< seconds until the remaining work should be finished
 			float i_scalability_graph[],		///< scalability graph
 			int i_scalability_graph_size,		///< size of scalability graph
 			bool i_update_resources_async = false	///< send upate message to client
 	)
 	{
 		if (cCommonData.verbosity_level > 2)
-			std::cout << cStopwatch.getTimeSinceStart() << "\t: " << i_client_pid << std::endl;
+			std::cout << getTimestamp() << "\t: " << i_client_pid << std::endl;
 
 		int clientVecId;
 		CClient *cClient = searchClient(i_client_pid, &clientVecId);
@@ -1017,11 +2108,22 @@ public:
 		}
 
 		cClient->retreat_active = false;
+		cClient->lending_active = false;
+		cClient->lent_cores.clear();
+		cClient->lend_return_cores = 0;
 		cClient->constraint_min_cores = i_min_cores;
 		cClient->constraint_max_cores = i_max_cores;
 		cClient->distribution_hint = i_distribution_hint;
+		cClient->recordDistributionHint(i_distribution_hint, CAllocationPredictor::max_history);
+		cClient->priority_class = std::max(0, std::min(i_priority_class, 7));
+		cClient->weight = (i_weight > 0 ? i_weight : 1.0f);
 		cClient->setScalabilityGraph(i_scalability_graph, i_scalability_graph_size);
 
+		double timestamp = getTimestamp();
+		cClient->deadline_remaining_work = std::max(i_remaining_work, 0.0f);
+		cClient->deadline_timestamp = timestamp;
+		cClient->deadline = (i_deadline > 0 ? timestamp + i_deadline : -1.0);
+
 		if (cCommonData.verbosity_level > 5 || cCommonData.verbosity_level <= -103)
 		{
 			std::cout << *cClient << ": invade - min/max cores: " << i_min_cores << "/" << i_max_cores << "   scalability: ";
@@ -1040,13 +2142,9 @@ public:
 			{
 				// number of assigned cores == 0
 				// => wait until resources are released
+				queueInvade(cClient);
 
-				if (cCommonData.verbosity_level >= 5)
-					std::cout << "DELAYED INVADE ACK (" << cClient->pid << ") => wait until at least one core is released!" << std::endl;
-
-				delayed_setup_acks_clients.push_back(cClient);
-
-				searchAndSendDelayedACKs();
+				admitQueuedClients();
 				return cClient->client_id;
 			}
 		}
@@ -1056,15 +2154,13 @@ public:
 
 			sendAsyncReinvadeAnswers();
 
-			searchAndSendDelayedACKs();
+			admitQueuedClients();
 
 			if (cClient->number_of_assigned_cores == 0)
 			{
 				// number of assigned cores == 0
 				// => wait until resources are released
-
-				std::cout << "DELAYED INVADE ACK (" << cClient->pid << ") => wait until at least one core is released!" << std::endl;
-				delayed_setup_acks_clients.push_back(cClient);
+				queueInvade(cClient);
 				return cClient->client_id;
 			}
 
@@ -1096,6 +2192,10 @@ public:
 			int i_min_cores,				///< minimum number of requested cores
 			int i_max_cores,				///< maximum number of requested cores
 			float i_distribution_hint,		///< distribution hint
+			int i_priority_class,			///< priority class
+			float i_weight,					///< weight within priority class
+			float i_remaining_work,			///< remaining work in seconds on a single core (<= 0: no deadline)
+			float i_deadline,				///< seconds until the remaining work should be finished
 			float i_scalability_graph[],	///< scalability graph
 			int i_scalability_graph_size	///< size of scalability graph
 	)
@@ -1106,6 +2206,10 @@ public:
 				i_min_cores,
 				i_max_cores,
 				i_distribution_hint,
+				i_priority_class,
+				i_weight,
+				i_remaining_work,
+				i_deadline,
 				i_scalability_graph,
 				i_scalability_graph_size,
 				true
@@ -1147,6 +2251,42 @@ public:
 		if (cClient->retreat_active)
 			return;
 
+		/*
+		 * translate physical cpu ids of client to logical core ids
+		 *
+		 * several cores of the client can be mapped to the same cpu
+		 * if the allowed cpu set shrank => use each core only once.
+		 *
+		 * cpus which are not mapped to a core of the client anymore (the
+		 * allowed cpu set changed while the reinvade was in flight) are dropped.
+		 */
+		std::vector<bool> core_used(cResources.max_cores, false);
+		int num_kept_cores = 0;
+		for (int i = 0; i < i_num_cores; i++)
+		{
+			int core_id = -1;
+			for (std::list<int>::iterator iter = cClient->assigned_cores.begin(); iter != cClient->assigned_cores.end(); iter++)
+			{
+				if (!core_used[*iter] && cResources.getPhysicalCpuId(*iter) == i_affinity_array[i])
+				{
+					core_id = *iter;
+					break;
+				}
+			}
+
+			if (core_id == -1)
+			{
+				if (cCommonData.verbosity_level > 2)
+					std::cout << *cClient << ": cpu " << i_affinity_array[i] << " is not assigned to the client anymore (dropped)" << std::endl;
+				continue;
+			}
+
+			core_used[core_id] = true;
+			i_affinity_array[num_kept_cores++] = core_id;
+		}
+
+		i_num_cores = num_kept_cores;
+
 		if (cCommonData.verbosity_level > 5 || cCommonData.verbosity_level <= -100)
 		{
 			std::cout << " + " << *cClient << " msg_incoming_reinvade_ack_async:" << std::endl;
@@ -1196,7 +2336,7 @@ public:
 
 		/*
 		 * Step 1)
-		 * Free all cores assigned to the client
+		 * Release all cores assigned to the client which are not kept
 		 *
 		 * Runtime: O(n)
 		 */
@@ -1207,8 +2347,8 @@ public:
 			assert(core_id >= 0);
 			assert(core_id < cResources.max_cores);
 
-			// free the core
-			cResources.core_pids[core_id] = 0;
+			if (!core_used[core_id])
+				cResources.releaseCore(core_id);
 		}
 
 
@@ -1228,8 +2368,8 @@ public:
 		 */
 		for (int core_id = 0; core_id < i_num_cores; core_id++)
 		{
+			assert(cResources.core_pids[i_affinity_array[core_id]] == cClient->pid);
 			cClient->assigned_cores.push_back(i_affinity_array[core_id]);
-			cResources.core_pids[i_affinity_array[core_id]] = cClient->pid;
 		}
 
 		if (cCommonData.verbosity_level <= -100)
@@ -1245,7 +2385,7 @@ public:
 		// update number of assigned cores
 		cClient->number_of_assigned_cores = i_num_cores;
 
-		searchAndSendDelayedACKs();
+		admitQueuedClients();
 
 		printCurrentState("msg_incoming_reinvade_ack_async (before_async_reinvade)", cClient->client_id);
 
@@ -1288,7 +2428,7 @@ public:
 		if (anythingChanged && cCommonData.verbosity_level > 2)
 		{
 //			std::cout << "++++++++++++++++++++++++++++++++++++++++++++++++" << std::endl;
-			std::cout << " + TIMESTAMP: " << cStopwatch.getTimeSinceStart() << std::endl;
+			std::cout << " + TIMESTAMP: " << getTimestamp() << std::endl;
 			std::cout << "  REINVADE for client " << cClient->client_id << std::endl;
 
 			std::cout << "  + pid: " << i_client_pid << std::endl;
@@ -1318,9 +2458,10 @@ public:
 		/*
 		 * send back mapping
 		 */
+		updateCgroupCpuset(cClient);
 		cMessages_Outgoing.msg_outgoing_sendInvadeAnswer(cClient, anythingChanged);
 
-		searchAndSendDelayedACKs();
+		admitQueuedClients();
 
 		sendAsyncReinvadeAnswers();
 	}
@@ -1353,6 +2494,9 @@ public:
 		}
 
 		cClient->retreat_active = true;
+		cClient->lending_active = false;
+		cClient->lent_cores.clear();
+		cClient->lend_return_cores = 0;
 
 
 		/*
@@ -1372,7 +2516,7 @@ public:
 
 		cMessages_Outgoing.msg_outgoing_ack(i_client_pid);
 
-		searchAndSendDelayedACKs();
+		admitQueuedClients();
 
 		sendAsyncReinvadeAnswers();
 
@@ -1381,6 +2525,101 @@ public:
 
 
 
+	/**
+	 * LEND from C1:
+	 *
+	 * - C1 already continues on its first core
+	 * - release all other cores of C1
+	 * - run global optimization to assign the lent cores to other clients
+	 *
+	 * lending is refused if an asynchronous resource update for C1 is still
+	 * pending since C1 might use other cores than the ones known here.
+	 */
+	void msg_incoming_lend(
+			pid_t i_client_pid		///< clients pid
+	)
+	{
+		int clientVecId;
+		CClient *cClient = searchClient(i_client_pid, &clientVecId);
+
+		if (cClient == 0)
+		{
+			if (cCommonData.verbosity_level > 5)
+				std::cout << "client not found -> ignoring lend" << std::endl;
+			return;
+		}
+
+		if (	cClient->lending_active ||
+				cClient->retreat_active ||
+				cClient->reinvade_nonblocking_active ||
+				cClient->number_of_assigned_cores <= 1
+		)
+		{
+			if (cCommonData.verbosity_level > 5)
+				std::cout << *cClient << ": lending refused" << std::endl;
+			return;
+		}
+
+		cClient->lending_active = true;
+		cClient->lend_return_cores = cClient->number_of_assigned_cores;
+
+		std::list<int>::iterator iter = cClient->assigned_cores.begin();
+		iter++;
+
+		cClient->lent_cores.assign(iter, cClient->assigned_cores.end());
+
+		for (; iter != cClient->assigned_cores.end(); iter++)
+			cResources.releaseCore(*iter);
+
+		cClient->assigned_cores.resize(1);
+		cClient->number_of_assigned_cores = 1;
+
+		if (cCommonData.verbosity_level > 5)
+			std::cout << *cClient << ": lending " << cClient->lent_cores.size() << " cores" << std::endl;
+
+		runGlobalOptimization();
+
+		admitQueuedClients();
+
+		sendAsyncReinvadeAnswers();
+
+		printCurrentState("lend", cClient->client_id);
+	}
+
+
+
+	/**
+	 * LEND END from C1:
+	 *
+	 * - C1 already continues on the cores used before lending
+	 * - run global optimization to request the borrowing clients to release
+	 *   the cores. the number of cores before lending is guaranteed to C1
+	 *   until it grew again and the lent cores are preferred for this.
+	 */
+	void msg_incoming_lend_end(
+			pid_t i_client_pid		///< clients pid
+	)
+	{
+		int clientVecId;
+		CClient *cClient = searchClient(i_client_pid, &clientVecId);
+
+		if (cClient == 0 || !cClient->lending_active)
+			return;
+
+		cClient->lending_active = false;
+
+		if (cCommonData.verbosity_level > 5)
+			std::cout << *cClient << ": lending finished" << std::endl;
+
+		runGlobalOptimization();
+
+		sendAsyncReinvadeAnswers();
+
+		printCurrentState("lend end", cClient->client_id);
+	}
+
+
+
 	/**
 	 * send shutdown message to ourself
 	 */
@@ -1413,7 +2652,15 @@ public:
 		}
 
 		if (cCommonData.verbosity_level >= 5)
-			std::cout << " + TIMESTAMP: " << cStopwatch.getTimeSinceStart() << std::endl;
+			std::cout << " + TIMESTAMP: " << getTimestamp() << std::endl;
+
+		if (perf_policy_active)
+			samplePerfCounters();
+
+		if (cpufreq_policy_active)
+			sampleCpuFreq();
+
+		checkAllowedCpus();
 
 		SPMOMessage &m = *(SPMOMessage*)(cMessageQueueServer->msg_data_load_ptr);
 
@@ -1424,7 +2671,8 @@ public:
 				printVerboseMsgIncomingHeader("CLIENT SETUP");
 
 				msg_incoming_clientSetup(
-						m.data.client_setup.pid
+						m.data.client_setup.pid,
+						m.data.client_setup.group_id
 					);
 				break;
 
@@ -1445,6 +2693,22 @@ public:
 					);
 				break;
 
+			case SPMOMessage::CLIENT_LEND:
+				printVerboseMsgIncomingHeader("CLIENT LEND");
+
+				msg_incoming_lend(
+						m.data.lend.pid
+					);
+				break;
+
+			case SPMOMessage::CLIENT_LEND_END:
+				printVerboseMsgIncomingHeader("CLIENT LEND END");
+
+				msg_incoming_lend_end(
+						m.data.lend.pid
+					);
+				break;
+
 			case SPMOMessage::CLIENT_INVADE:
 				printVerboseMsgIncomingHeader("CLIENT INVADE");
 
@@ -1453,9 +2717,15 @@ public:
 						m.data.invade.min_cpus,
 						m.data.invade.max_cpus,
 						m.data.invade.distribution_hint,
+						m.data.invade.priority_class,
+						m.data.invade.weight,
+						m.data.invade.remaining_work,
+						m.data.invade.deadline,
 						m.data.invade.scalability_graph,
 						m.data.invade.scalability_graph_size
 					);
+
+				prestagePredictedOptima();
 				break;
 
 			case SPMOMessage::CLIENT_INVADE_NONBLOCKING:
@@ -1466,9 +2736,15 @@ public:
 						m.data.invade.min_cpus,
 						m.data.invade.max_cpus,
 						m.data.invade.distribution_hint,
+						m.data.invade.priority_class,
+						m.data.invade.weight,
+						m.data.invade.remaining_work,
+						m.data.invade.deadline,
 						m.data.invade.scalability_graph,
 						m.data.invade.scalability_graph_size
 					);
+
+				prestagePredictedOptima();
 				break;
 
 			case SPMOMessage::CLIENT_REINVADE_ACK_NONBLOCKING:
@@ -1502,6 +2778,10 @@ public:
 				break;
 		}
 
+		flushCgroupCpusets();
+
+		exportResourceMap();
+
 		validateResources();
 		return true;
 	}
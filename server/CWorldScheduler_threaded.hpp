@@ -17,9 +17,15 @@ class CWorldScheduler_threaded
 
 	CWorldScheduler *cWorldScheduler;
 
+	/**
+	 * SCHED_FIFO priority of the scheduler thread, 0 for default scheduling policy
+	 */
+	int realtime_priority;
+
 public:
 	CWorldScheduler_threaded()	:
-		cWorldScheduler(nullptr)
+		cWorldScheduler(nullptr),
+		realtime_priority(0)
 	{
 	}
 
@@ -28,6 +34,9 @@ public:
 	{
 		CWorldScheduler_threaded *w = (CWorldScheduler_threaded*) ptr;
 
+		// pin to reserved cores to avoid competing with the cores handed out to the clients
+		w->cWorldScheduler->pinSchedulerThread(w->realtime_priority);
+
 		while (true)
 		{
 			if (!w->cWorldScheduler->action())
@@ -40,13 +49,25 @@ public:
 	void start(
 			int i_max_cores = -1,		///< initialize system with max-cores
 			int i_verbose_level = 2,	///< verbosity level
-			bool i_color_mode = false	///< use colored output
+			bool i_color_mode = false,	///< use colored output
+			const char *i_reserved_cpu_list = nullptr,	///< cpus reserved for the scheduler thread (e.g. "0")
+			bool i_reserve_smt_siblings = false,		///< additionally reserve the SMT siblings of these cpus
+			int i_realtime_priority = 0,				///< SCHED_FIFO priority of the scheduler thread
+			int i_prediction_plans = 0					///< number of precomputed solutions for predicted distribution hints (0: deactivated)
 	)
 	{
 		assert(cWorldScheduler == nullptr);
 
 		cWorldScheduler = new CWorldScheduler(i_max_cores, i_verbose_level, i_color_mode);
 
+		if (i_reserved_cpu_list != nullptr)
+			cWorldScheduler->setupReservedCores(i_reserved_cpu_list, i_reserve_smt_siblings);
+
+		if (i_prediction_plans > 0)
+			cWorldScheduler->setupPrediction(i_prediction_plans);
+
+		realtime_priority = i_realtime_priority;
+
 		pthread_create(&thread, NULL, &worldSchedulerThread, this);
 	}
 
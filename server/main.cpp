@@ -50,11 +50,23 @@ void myCTRLCHandler(int s)
 int verbosity_level = 2;
 int max_cores = -1;
 bool color_mode = false;
+bool perf_counters = false;
+bool cpufreq = false;
+const char *cpufreq_sysfs_path = "/sys/devices/system/cpu";
+CGlobalOptimizer::EOptimizer optimizer = CGlobalOptimizer::OPTIMIZER_AUTO;
+double optimizer_time_budget = 0.01;
+int optimizer_threads = 1;
+const char *optimizer_cpu_list = nullptr;
+const char *reserved_cpu_list = nullptr;
+bool reserve_smt_siblings = false;
+int realtime_priority = 0;
+const char *cgroup_path = nullptr;
+int prediction_plans = 0;
 
 int main(int argc, char *argv[])
 {
 	char optchar;
-	while ((optchar = getopt(argc, argv, "cn:v:")) > 0)
+	while ((optchar = getopt(argc, argv, "cfF:g:j:J:o:pn:P:r:R:st:v:")) > 0)
 	{
 		switch(optchar)
 		{
@@ -70,6 +82,62 @@ int main(int argc, char *argv[])
 			max_cores = atoi(optarg);
 			break;
 
+		case 'p':
+			perf_counters = true;
+			break;
+
+		case 'f':
+			cpufreq = true;
+			break;
+
+		case 'F':
+			cpufreq = true;
+			cpufreq_sysfs_path = optarg;
+			break;
+
+		case 'o':
+			if (strcmp(optarg, "auto") == 0)
+				optimizer = CGlobalOptimizer::OPTIMIZER_AUTO;
+			else if (strcmp(optarg, "greedy") == 0)
+				optimizer = CGlobalOptimizer::OPTIMIZER_GREEDY;
+			else if (strcmp(optarg, "dp") == 0)
+				optimizer = CGlobalOptimizer::OPTIMIZER_DP;
+			else
+				goto parameter_error;
+			break;
+
+		case 't':
+			optimizer_time_budget = atof(optarg);
+			break;
+
+		case 'j':
+			optimizer_threads = atoi(optarg);
+			break;
+
+		case 'J':
+			optimizer_cpu_list = optarg;
+			break;
+
+		case 'r':
+			reserved_cpu_list = optarg;
+			break;
+
+		case 's':
+			reserve_smt_siblings = true;
+			break;
+
+		case 'R':
+			realtime_priority = atoi(optarg);
+			break;
+
+		case 'g':
+			cgroup_path = optarg;
+			break;
+
+		case 'P':
+			prediction_plans = atoi(optarg);
+			break;
+
 		case 'h':
 		default:
 			goto parameter_error;
@@ -82,6 +150,18 @@ parameter_error:
 	std::cout << "	[-v [int]: verbose mode (0-100), tabular output (-99)]" << std::endl;
 	std::cout << "	[-n [int]: number of threads to use]" << std::endl;
 	std::cout << "	[-c : activate color mode]" << std::endl;
+	std::cout << "	[-p : activate hardware performance counters and NUMA placement of memory bound clients]" << std::endl;
+	std::cout << "	[-f : activate frequency aware allocation]" << std::endl;
+	std::cout << "	[-F [path]: activate frequency aware allocation with cpu information in given directory instead of /sys/devices/system/cpu]" << std::endl;
+	std::cout << "	[-o [auto/greedy/dp]: solver for the global optimization, default: auto]" << std::endl;
+	std::cout << "	[-t [float]: time budget in seconds for the dynamic programming solver, default: 0.01]" << std::endl;
+	std::cout << "	[-j [int]: number of threads for the parallel global optimization of large problems, default: 1]" << std::endl;
+	std::cout << "	[-J [cpulist]: cpus for the threads of the global optimization (e.g. 8-11), default: reserved cpus or cpus not managed by the server]" << std::endl;
+	std::cout << "	[-r [cpulist]: reserve cpus for the server (e.g. 0), the server is pinned to these cpus]" << std::endl;
+	std::cout << "	[-s : additionally reserve the SMT siblings of the reserved cpus]" << std::endl;
+	std::cout << "	[-R [int]: run the server with the given SCHED_FIFO real-time priority]" << std::endl;
+	std::cout << "	[-g [path]: enforce the core distribution with cgroup v2 cpusets created in the given directory]" << std::endl;
+	std::cout << "	[-P [int]: precompute up to the given number of solutions of the global optimization for predicted distribution hints]" << std::endl;
 	return -1;
 
 
@@ -90,6 +170,26 @@ parameter_ok:
 
 	cWorldScheduler = new CWorldScheduler(max_cores, verbosity_level, color_mode);
 
+	if (perf_counters)
+		cWorldScheduler->setupPerfCounters();
+
+	if (cpufreq)
+		cWorldScheduler->setupCpuFreq(cpufreq_sysfs_path);
+
+	if (cgroup_path != nullptr)
+		cWorldScheduler->setupCgroupCpuset(cgroup_path);
+
+	if (reserved_cpu_list != nullptr)
+		cWorldScheduler->setupReservedCores(reserved_cpu_list, reserve_smt_siblings);
+
+	cWorldScheduler->pinSchedulerThread(realtime_priority);
+
+	cWorldScheduler->setupOptimizer(optimizer, optimizer_time_budget);
+	cWorldScheduler->setupOptimizerThreads(optimizer_threads, optimizer_cpu_list);
+
+	if (prediction_plans > 0)
+		cWorldScheduler->setupPrediction(prediction_plans);
+
 //	signal(SIGABRT, &myCTRLCHandler);
 //	signal(SIGTERM, &myCTRLCHandler);
 	signal(SIGINT, &myCTRLCHandler);
@@ -0,0 +1,134 @@
+/*
+ * CMessageQueueSimulation.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Virtual message queue replacing the system message queue of the world
+ * scheduler in simulations.
+ *
+ * Messages of the simulated clients are stored until the simulator lets the
+ * world scheduler receive them with receiveFromClient(). Messages sent by
+ * the world scheduler are stored until the simulator delivers them to the
+ * simulated clients.
+ */
+
+#ifndef CMESSAGEQUEUESIMULATION_HPP_
+#define CMESSAGEQUEUESIMULATION_HPP_
+
+#include <vector>
+#include <deque>
+#include <string.h>
+
+#include "../include/CMessageQueueServer.hpp"
+
+
+
+class CMessageQueueSimulation	: public CMessageQueueServer
+{
+public:
+	struct SMessage
+	{
+		long int mtype;				///< pid of the receiving client
+		std::vector<char> data;		///< raw message without mtype
+	};
+
+private:
+	/**
+	 * messages to the world scheduler
+	 */
+	std::deque<std::vector<char> > server_messages;
+
+	/**
+	 * messages to the clients
+	 */
+	std::deque<SMessage> client_messages;
+
+
+public:
+	CMessageQueueSimulation(
+			int i_verbose_level = 0
+	)
+	{
+		verbose_level = i_verbose_level;
+	}
+
+
+
+	/**
+	 * store a message of the world scheduler packed into msg_data_load_ptr
+	 */
+	void sendToClient(
+		size_t i_length,	///< length of message without mtype!
+		long int i_mtype
+	)
+	{
+		assert(i_length <= max_msg_size);
+
+		client_messages.push_back(SMessage());
+
+		SMessage &m = client_messages.back();
+		m.mtype = i_mtype;
+		m.data.assign((char*)msg_data_load_ptr, (char*)msg_data_load_ptr + i_length);
+	}
+
+
+
+	/**
+	 * copy the next message of a client to msg_data_load_ptr
+	 *
+	 * \return length of the message or -1 if there's no message
+	 */
+	int receiveFromClient(
+			long i_mtype = 1
+	)
+	{
+		if (server_messages.empty())
+			return -1;
+
+		std::vector<char> &data = server_messages.front();
+		memcpy(msg_data_load_ptr, data.data(), data.size());
+
+		int length = data.size();
+		server_messages.pop_front();
+		return length;
+	}
+
+
+
+	/**
+	 * store a message of a simulated client to the world scheduler
+	 */
+	void sendToServer(
+			const std::vector<char> &i_data
+	)
+	{
+		assert(i_data.size() <= max_msg_size);
+
+		server_messages.push_back(i_data);
+	}
+
+
+
+	/**
+	 * take the next message of the world scheduler to a client
+	 *
+	 * \return false if there's no message
+	 */
+	bool receiveFromServer(
+			SMessage &o_message
+	)
+	{
+		if (client_messages.empty())
+			return false;
+
+		o_message.mtype = client_messages.front().mtype;
+		o_message.data.swap(client_messages.front().data);
+		client_messages.pop_front();
+		return true;
+	}
+};
+
+
+#endif /* CMESSAGEQUEUESIMULATION_HPP_ */
@@ -0,0 +1,423 @@
+/*
+ * CSimulatedClient.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Client of the simulator following the protocol of CPMO with nonblocking
+ * invades and reinvades.
+ *
+ * The workload of a client consists of phases. Each phase has an amount of
+ * work in seconds on a single core and a scalability graph which is sent to
+ * the world scheduler with an invade at the start of the phase. The work is
+ * processed with the speedup of the scalability graph for the number of cores
+ * currently used by the client.
+ *
+ * Like a real client, resource updates of the world scheduler are processed
+ * at the next checkpoint of the application (see
+ * CPMO::reinvade_nonblocking()), hence the simulator delivers the queued
+ * messages after a checkpoint interval.
+ */
+
+#ifndef CSIMULATEDCLIENT_HPP_
+#define CSIMULATEDCLIENT_HPP_
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <sys/types.h>
+
+#include "../include/SPMOMessage.hpp"
+
+
+
+class CSimulatedClient
+{
+public:
+	struct SPhase
+	{
+		double work;							///< work in seconds on a single core
+		std::vector<float> scalability_graph;	///< speedup for 1, 2, 3, ... cores
+	};
+
+	enum EState
+	{
+		STATE_ARRIVING,		///< not connected to the world scheduler so far
+		STATE_SETUP,		///< waiting for the ack of the client setup
+		STATE_RUNNING,		///< processing the phases
+		STATE_SHUTDOWN,		///< waiting for the ack of the shutdown
+		STATE_FINISHED
+	};
+
+	/*
+	 * workload
+	 */
+	pid_t pid;						///< simulated pid, no process of the system
+	double arrival_timestamp;
+	int max_cores;					///< maximum number of cores requested with each invade
+	std::vector<SPhase> phases;
+
+	/*
+	 * state
+	 */
+	EState state;
+	int phase;
+	double remaining_work;			///< remaining work of the current phase
+	double progress_timestamp;		///< time of the last update of the remaining work
+	std::vector<int> cpus;			///< cpu of each thread
+
+	/**
+	 * resource updates of the world scheduler processed at the next checkpoint
+	 */
+	std::deque<std::vector<char> > pending_messages;
+
+	/**
+	 * incremented whenever the time at which the current phase ends changes
+	 */
+	int phase_end_version;
+
+	/*
+	 * statistics
+	 */
+	double first_core_timestamp;	///< time at which the first core was used (-1: no core so far)
+	double finish_timestamp;		///< time at which the last phase was finished (-1: not finished)
+	double core_seconds;			///< used cores integrated over time
+	int resource_updates;			///< number of changes of the cores
+	int thread_migrations;			///< number of threads moved to another cpu
+	bool queued;					///< the invade was queued in the admission queue
+
+
+
+	CSimulatedClient()	:
+		pid(0),
+		arrival_timestamp(0),
+		max_cores(1),
+		state(STATE_ARRIVING),
+		phase(0),
+		remaining_work(0),
+		progress_timestamp(0),
+		phase_end_version(0),
+		first_core_timestamp(-1),
+		finish_timestamp(-1),
+		core_seconds(0),
+		resource_updates(0),
+		thread_migrations(0),
+		queued(false)
+	{
+	}
+
+
+
+	/**
+	 * return the work of all phases
+	 */
+	double getTotalWork()	const
+	{
+		double w = 0;
+		for (size_t i = 0; i < phases.size(); i++)
+			w += phases[i].work;
+		return w;
+	}
+
+
+
+	/**
+	 * return the speedup of the current phase
+	 *
+	 * this is the same interpretation of the scalability graph as in CClient::getScalability()
+	 */
+	double getSpeedup(
+			int i_num_cores
+	)	const
+	{
+		if (i_num_cores <= 0)
+			return 0;
+
+		const std::vector<float> &g = phases[phase].scalability_graph;
+
+		if (g.empty())
+			return i_num_cores;
+
+		return g[std::min(i_num_cores, (int)g.size())-1];
+	}
+
+
+
+	/**
+	 * update the remaining work of the current phase up to the given time
+	 */
+	void updateProgress(
+			double i_timestamp
+	)
+	{
+		double dt = i_timestamp - progress_timestamp;
+
+		if (dt > 0 && state == STATE_RUNNING)
+		{
+			remaining_work -= dt*getSpeedup(cpus.size());
+			core_seconds += dt*(double)cpus.size();
+		}
+
+		progress_timestamp = i_timestamp;
+	}
+
+
+
+	/**
+	 * return the time at which the current phase ends with the current cores
+	 *
+	 * \return -1 if the client doesn't progress
+	 */
+	double getPhaseEndTimestamp()	const
+	{
+		if (state != STATE_RUNNING)
+			return -1;
+
+		double s = getSpeedup(cpus.size());
+		if (s <= 0)
+			return -1;
+
+		return progress_timestamp + std::max(remaining_work, 0.0)/s;
+	}
+
+
+
+	/**
+	 * connect to the world scheduler
+	 */
+	void arrive(
+			double i_timestamp,
+			std::vector<std::vector<char> > &o_messages		///< messages to the world scheduler
+	)
+	{
+		state = STATE_SETUP;
+		progress_timestamp = i_timestamp;
+
+		o_messages.push_back(std::vector<char>(sizeof(SPMOMessage)));
+		SPMOMessage &m = *(SPMOMessage*)o_messages.back().data();
+
+		m.package_type = SPMOMessage::CLIENT_SETUP;
+		m.data.client_setup.pid = pid;
+		m.data.client_setup.seq_id = 0;
+		m.data.client_setup.group_id = 0;
+
+		o_messages.back().resize((size_t)&(m.data) - (size_t)&m + sizeof(m.data.client_setup));
+	}
+
+
+
+	/**
+	 * handle a message of the world scheduler
+	 *
+	 * \return true if the message has to be processed at the next checkpoint
+	 */
+	bool handleServerMessage(
+			std::vector<char> &io_data,
+			double i_timestamp,
+			std::vector<std::vector<char> > &o_messages		///< messages to the world scheduler
+	)
+	{
+		SPMOMessage &m = *(SPMOMessage*)io_data.data();
+
+		switch(m.package_type)
+		{
+		case SPMOMessage::SERVER_ACK:
+			if (state != STATE_SETUP)
+				return false;
+
+			// the client setup was acknowledged => start the first phase
+			state = STATE_RUNNING;
+			progress_timestamp = i_timestamp;
+			startPhase(0, o_messages);
+			return false;
+
+		case SPMOMessage::SERVER_INVADE_QUEUED:
+			queued = true;
+			return false;
+
+		case SPMOMessage::SERVER_INVADE_ANSWER:
+		case SPMOMessage::SERVER_REINVADE_NONBLOCKING:
+			if (state != STATE_RUNNING)
+				return false;
+
+			pending_messages.push_back(std::vector<char>());
+			pending_messages.back().swap(io_data);
+
+			// a checkpoint is already pending for previous messages
+			return pending_messages.size() == 1;
+
+		case SPMOMessage::CLIENT_ACK_SHUTDOWN:
+			state = STATE_FINISHED;
+			return false;
+
+		default:
+			std::cerr << "UNKNOWN MESSAGE TYPE " << m.package_type << " for simulated client " << pid << std::endl;
+			return false;
+		}
+	}
+
+
+
+	/**
+	 * process the resource updates of the world scheduler at a checkpoint
+	 */
+	void checkpoint(
+			double i_timestamp,
+			std::vector<std::vector<char> > &o_messages		///< messages to the world scheduler
+	)
+	{
+		for (; !pending_messages.empty(); pending_messages.pop_front())
+		{
+			if (state != STATE_RUNNING)
+				continue;
+
+			SPMOMessage &m = *(SPMOMessage*)pending_messages.front().data();
+
+			if (m.package_type == SPMOMessage::SERVER_INVADE_ANSWER)
+			{
+				if (m.data.invade_answer.anythingChanged)
+					applyCpus(m.data.invade_answer.affinity_array, m.data.invade_answer.number_of_cores, i_timestamp);
+
+				continue;
+			}
+
+			assert(m.package_type == SPMOMessage::SERVER_REINVADE_NONBLOCKING);
+
+			applyCpus(m.data.invade_answer.affinity_array, m.data.invade_answer.number_of_cores, i_timestamp);
+
+			// send the cpus which are used now
+			int n = cpus.size();
+
+			o_messages.push_back(std::vector<char>(sizeof(SPMOMessage) + sizeof(int)*n));
+			SPMOMessage &a = *(SPMOMessage*)o_messages.back().data();
+
+			a.package_type = SPMOMessage::CLIENT_REINVADE_ACK_NONBLOCKING;
+			a.data.reinvade_ack_async.pid = pid;
+			a.data.reinvade_ack_async.seq_id = 0;
+			a.data.reinvade_ack_async.anythingChanged = true;
+			a.data.reinvade_ack_async.number_of_cores = n;
+
+			for (int i = 0; i < n; i++)
+				a.data.reinvade_ack_async.affinity_array[i] = cpus[i];
+
+			o_messages.back().resize(
+					(size_t)&(a.data.reinvade_ack_async) - (size_t)&a +
+					sizeof(a.data.reinvade_ack_async) +
+					sizeof(int)*(n-1)
+				);
+		}
+	}
+
+
+
+	/**
+	 * the current phase was finished => start the next phase or shutdown
+	 */
+	void finishPhase(
+			double i_timestamp,
+			std::vector<std::vector<char> > &o_messages		///< messages to the world scheduler
+	)
+	{
+		updateProgress(i_timestamp);
+		remaining_work = 0;
+
+		if (phase+1 < (int)phases.size())
+		{
+			startPhase(phase+1, o_messages);
+			return;
+		}
+
+		finish_timestamp = i_timestamp;
+		state = STATE_SHUTDOWN;
+		cpus.clear();
+		pending_messages.clear();
+		phase_end_version++;
+
+		o_messages.push_back(std::vector<char>(sizeof(SPMOMessage)));
+		SPMOMessage &m = *(SPMOMessage*)o_messages.back().data();
+
+		m.package_type = SPMOMessage::CLIENT_SHUTDOWN;
+		m.data.client_shutdown.pid = pid;
+		m.data.client_shutdown.seq_id = 0;
+		m.data.client_shutdown.client_shutdown_hint = getTotalWork();
+
+		o_messages.back().resize((size_t)&(m.data) - (size_t)&m + sizeof(m.data.client_shutdown));
+	}
+
+
+
+private:
+	/**
+	 * start a phase and send its scalability graph with a nonblocking invade
+	 */
+	void startPhase(
+			int i_phase,
+			std::vector<std::vector<char> > &o_messages		///< messages to the world scheduler
+	)
+	{
+		phase = i_phase;
+		remaining_work = phases[phase].work;
+		phase_end_version++;
+
+		const std::vector<float> &g = phases[phase].scalability_graph;
+		int n = g.size();
+
+		o_messages.push_back(std::vector<char>(sizeof(SPMOMessage) + sizeof(float)*n));
+		SPMOMessage &m = *(SPMOMessage*)o_messages.back().data();
+
+		m.package_type = SPMOMessage::CLIENT_INVADE_NONBLOCKING;
+		m.data.invade.pid = pid;
+		m.data.invade.seq_id = 0;
+		m.data.invade.min_cpus = 1;
+		m.data.invade.max_cpus = max_cores;
+		m.data.invade.distribution_hint = -1;
+		m.data.invade.priority_class = 0;
+		m.data.invade.weight = 1.0f;
+		m.data.invade.remaining_work = 0;
+		m.data.invade.deadline = 0;
+		m.data.invade.scalability_graph_size = n;
+
+		for (int i = 0; i < n; i++)
+			m.data.invade.scalability_graph[i] = g[i];
+
+		o_messages.back().resize(
+				(size_t)&(m.data.invade) - (size_t)&m +
+				sizeof(m.data.invade) +
+				sizeof(float)*(n-1)
+			);
+	}
+
+
+
+	/**
+	 * use new cpus for the threads
+	 */
+	void applyCpus(
+			const int *i_cpus,
+			int i_num_cpus,
+			double i_timestamp
+	)
+	{
+		updateProgress(i_timestamp);
+
+		// thread i is pinned to the i-th cpu (see CPMO::applyAffinities())
+		int n = std::min((int)cpus.size(), i_num_cpus);
+		for (int i = 0; i < n; i++)
+			if (cpus[i] != i_cpus[i])
+				thread_migrations++;
+
+		cpus.assign(i_cpus, i_cpus+i_num_cpus);
+		resource_updates++;
+
+		if (first_core_timestamp < 0 && i_num_cpus > 0)
+			first_core_timestamp = i_timestamp;
+
+		phase_end_version++;
+	}
+};
+
+
+#endif /* CSIMULATEDCLIENT_HPP_ */
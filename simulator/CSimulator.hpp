@@ -0,0 +1,387 @@
+/*
+ * CSimulator.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Discrete event simulation of the world scheduler with simulated clients.
+ *
+ * The message handlers of CWorldScheduler are executed unmodified, but the
+ * messages are exchanged with the virtual message queue
+ * CMessageQueueSimulation and the time of the world scheduler is the virtual
+ * time of the simulation. Each message is delivered after a fixed latency
+ * and the world scheduler processes each message without consuming virtual
+ * time.
+ *
+ * The events are processed in the order of their virtual time (events at the
+ * same time in the order of their creation), hence a simulation is
+ * deterministic unless the solver of the global optimization depends on the
+ * real time (time budget of the dynamic programming solver).
+ */
+
+#ifndef CSIMULATOR_HPP_
+#define CSIMULATOR_HPP_
+
+#include <vector>
+#include <queue>
+#include <iostream>
+#include <algorithm>
+
+#include "../server/CWorldScheduler.hpp"
+#include "../include/CStopwatch.hpp"
+#include "CMessageQueueSimulation.hpp"
+#include "CSimulatedClient.hpp"
+
+
+
+class CSimulator
+{
+	enum EEventType
+	{
+		EVENT_CLIENT_ARRIVAL,		///< client connects to the world scheduler
+		EVENT_SERVER_RECEIVE,		///< message of a client arrives at the world scheduler
+		EVENT_CLIENT_RECEIVE,		///< message of the world scheduler arrives at a client
+		EVENT_CLIENT_CHECKPOINT,	///< client processes the resource updates
+		EVENT_CLIENT_PHASE_END		///< client finished the work of its current phase
+	};
+
+	struct SEvent
+	{
+		double timestamp;
+		unsigned long id;			///< order of creation
+		EEventType type;
+		int client_id;				///< index of the simulated client
+		int version;				///< phase end version of the client (EVENT_CLIENT_PHASE_END)
+		std::vector<char> data;		///< message (EVENT_SERVER_RECEIVE, EVENT_CLIENT_RECEIVE)
+
+		/**
+		 * order for the priority queue: the earliest event is processed first
+		 */
+		bool operator<(const SEvent &i_event)	const
+		{
+			if (timestamp != i_event.timestamp)
+				return timestamp > i_event.timestamp;
+
+			return id > i_event.id;
+		}
+	};
+
+	std::priority_queue<SEvent> events;
+	unsigned long event_id;
+
+	CMessageQueueSimulation cMessageQueueSimulation;
+
+	CWorldScheduler *cWorldScheduler;
+
+	int num_cores;
+
+	int verbose_level;
+
+
+public:
+	/**
+	 * pid of the first simulated client
+	 */
+	static const pid_t pid_offset = 1000000;
+
+	std::vector<CSimulatedClient> clients;
+
+	/**
+	 * latency of each message in seconds
+	 */
+	double message_latency;
+
+	/**
+	 * time between two checkpoints of the clients in seconds
+	 */
+	double checkpoint_interval;
+
+	/*
+	 * statistics
+	 */
+	unsigned long num_events;
+	unsigned long num_server_messages;
+	double scheduler_seconds;		///< real time spent in the message handlers of the world scheduler
+	double simulation_seconds;		///< real time of the simulation
+
+
+
+	CSimulator(
+			int i_num_cores,
+			int i_verbose_level,			///< verbosity level of the simulator
+			int i_scheduler_verbose_level	///< verbosity level of the world scheduler
+	)	:
+		event_id(0),
+		num_cores(i_num_cores),
+		verbose_level(i_verbose_level),
+		message_latency(10e-6),
+		checkpoint_interval(1e-3),
+		num_events(0),
+		num_server_messages(0),
+		scheduler_seconds(0),
+		simulation_seconds(0)
+	{
+		cWorldScheduler = new CWorldScheduler(i_num_cores, i_scheduler_verbose_level, false, &cMessageQueueSimulation);
+	}
+
+
+
+	~CSimulator()
+	{
+		delete cWorldScheduler;
+	}
+
+
+
+	/**
+	 * return the world scheduler to setup its policies
+	 */
+	CWorldScheduler &getWorldScheduler()
+	{
+		return *cWorldScheduler;
+	}
+
+
+
+	/**
+	 * add a client, its pid is assigned by the simulator
+	 */
+	void addClient(
+			const CSimulatedClient &i_cClient
+	)
+	{
+		clients.push_back(i_cClient);
+		clients.back().pid = pid_offset + clients.size()-1;
+	}
+
+
+
+private:
+	void pushEvent(
+			double i_timestamp,
+			EEventType i_type,
+			int i_client_id,
+			int i_version = 0
+	)
+	{
+		SEvent e;
+		e.timestamp = i_timestamp;
+		e.id = event_id++;
+		e.type = i_type;
+		e.client_id = i_client_id;
+		e.version = i_version;
+
+		events.push(e);
+	}
+
+
+
+	void pushMessageEvent(
+			double i_timestamp,
+			EEventType i_type,
+			int i_client_id,
+			std::vector<char> &io_data
+	)
+	{
+		SEvent e;
+		e.timestamp = i_timestamp;
+		e.id = event_id++;
+		e.type = i_type;
+		e.client_id = i_client_id;
+		e.version = 0;
+		e.data.swap(io_data);
+
+		events.push(e);
+	}
+
+
+
+	/**
+	 * let the world scheduler process a message of a client and deliver its answers
+	 */
+	void serverReceive(
+			SEvent &i_event
+	)
+	{
+		cMessageQueueSimulation.sendToServer(i_event.data);
+
+		cWorldScheduler->setVirtualTimestamp(i_event.timestamp);
+
+		CStopwatch cStopwatch;
+		cStopwatch.start();
+
+		cWorldScheduler->action();
+
+		scheduler_seconds += cStopwatch.getTimeSinceStart();
+		num_server_messages++;
+
+		CMessageQueueSimulation::SMessage m;
+		while (cMessageQueueSimulation.receiveFromServer(m))
+		{
+			int client_id = m.mtype - pid_offset;
+
+			if (client_id < 0 || client_id >= (int)clients.size())
+			{
+				std::cerr << "message to unknown client " << m.mtype << " ignored" << std::endl;
+				continue;
+			}
+
+			pushMessageEvent(i_event.timestamp + message_latency, EVENT_CLIENT_RECEIVE, client_id, m.data);
+		}
+	}
+
+
+
+public:
+	/**
+	 * run the simulation until all events were processed
+	 */
+	void run()
+	{
+		CStopwatch cStopwatch;
+		cStopwatch.start();
+
+		for (size_t i = 0; i < clients.size(); i++)
+			pushEvent(clients[i].arrival_timestamp, EVENT_CLIENT_ARRIVAL, i);
+
+		std::vector<std::vector<char> > messages;
+
+		while (!events.empty())
+		{
+			SEvent e = events.top();
+			events.pop();
+
+			num_events++;
+
+			if (e.type == EVENT_SERVER_RECEIVE)
+			{
+				serverReceive(e);
+				continue;
+			}
+
+			CSimulatedClient &c = clients[e.client_id];
+			int phase_end_version = c.phase_end_version;
+
+			switch(e.type)
+			{
+			case EVENT_CLIENT_ARRIVAL:
+				if (verbose_level > 2)
+					std::cout << e.timestamp << ": client " << c.pid << " arrives" << std::endl;
+
+				c.arrive(e.timestamp, messages);
+				break;
+
+			case EVENT_CLIENT_RECEIVE:
+				if (c.handleServerMessage(e.data, e.timestamp, messages))
+					pushEvent(e.timestamp + checkpoint_interval, EVENT_CLIENT_CHECKPOINT, e.client_id);
+				break;
+
+			case EVENT_CLIENT_CHECKPOINT:
+				c.checkpoint(e.timestamp, messages);
+				break;
+
+			case EVENT_CLIENT_PHASE_END:
+				// the phase end time changed in the meantime
+				if (e.version != c.phase_end_version)
+					break;
+
+				if (verbose_level > 2)
+					std::cout << e.timestamp << ": client " << c.pid << " finished phase " << c.phase << " with " << c.cpus.size() << " cores" << std::endl;
+
+				c.finishPhase(e.timestamp, messages);
+				break;
+
+			default:
+				break;
+			}
+
+			for (size_t i = 0; i < messages.size(); i++)
+				pushMessageEvent(e.timestamp + message_latency, EVENT_SERVER_RECEIVE, e.client_id, messages[i]);
+			messages.clear();
+
+			if (c.phase_end_version != phase_end_version)
+			{
+				double t = c.getPhaseEndTimestamp();
+
+				if (t >= 0)
+					pushEvent(std::max(t, e.timestamp), EVENT_CLIENT_PHASE_END, e.client_id, c.phase_end_version);
+			}
+		}
+
+		simulation_seconds = cStopwatch.getTimeSinceStart();
+	}
+
+
+
+	/**
+	 * print makespan, utilization and migrations
+	 */
+	void printStatistics()
+	{
+		int num_finished = 0;
+		int num_queued = 0;
+		double first_arrival = -1;
+		double last_finish = 0;
+		double sum_work = 0;
+		double sum_core_seconds = 0;
+		double sum_turnaround = 0;
+		double max_turnaround = 0;
+		double sum_wait = 0;
+		double max_wait = 0;
+		long sum_resource_updates = 0;
+		long sum_thread_migrations = 0;
+
+		for (size_t i = 0; i < clients.size(); i++)
+		{
+			CSimulatedClient &c = clients[i];
+
+			if (first_arrival < 0 || c.arrival_timestamp < first_arrival)
+				first_arrival = c.arrival_timestamp;
+
+			sum_core_seconds += c.core_seconds;
+			sum_resource_updates += c.resource_updates;
+			sum_thread_migrations += c.thread_migrations;
+
+			if (c.queued)
+				num_queued++;
+
+			if (c.finish_timestamp < 0)
+				continue;
+
+			num_finished++;
+			sum_work += c.getTotalWork();
+			last_finish = std::max(last_finish, c.finish_timestamp);
+
+			double turnaround = c.finish_timestamp - c.arrival_timestamp;
+			sum_turnaround += turnaround;
+			max_turnaround = std::max(max_turnaround, turnaround);
+
+			double wait = c.first_core_timestamp - c.arrival_timestamp;
+			sum_wait += wait;
+			max_wait = std::max(max_wait, wait);
+		}
+
+		double makespan = last_finish - first_arrival;
+		double n = std::max(num_finished, 1);
+
+		std::cout << "clients: " << clients.size() << " (" << num_finished << " finished, " << num_queued << " queued for admission)" << std::endl;
+		std::cout << "cores: " << num_cores << std::endl;
+		std::cout << "makespan: " << makespan << " s" << std::endl;
+		std::cout << "utilization: " << (makespan > 0 ? sum_core_seconds/((double)num_cores*makespan) : 0) << std::endl;
+		std::cout << "parallel efficiency: " << (sum_core_seconds > 0 ? sum_work/sum_core_seconds : 0) << std::endl;
+		std::cout << "turnaround time: " << sum_turnaround/n << " s average, " << max_turnaround << " s maximum" << std::endl;
+		std::cout << "wait time for the first core: " << sum_wait/n << " s average, " << max_wait << " s maximum" << std::endl;
+		std::cout << "resource updates: " << sum_resource_updates << " (" << (double)sum_resource_updates/(double)std::max((int)clients.size(), 1) << " per client)" << std::endl;
+		std::cout << "thread migrations: " << sum_thread_migrations << " (" << (double)sum_thread_migrations/(double)std::max((int)clients.size(), 1) << " per client)" << std::endl;
+		std::cout << "messages to the world scheduler: " << num_server_messages << " (" << (num_server_messages > 0 ? scheduler_seconds*1000000.0/(double)num_server_messages : 0) << " us per message)" << std::endl;
+		std::cout << "events: " << num_events << std::endl;
+		std::cout << "simulation time: " << simulation_seconds << " s" << std::endl;
+
+		if (num_finished < (int)clients.size())
+			std::cout << "WARNING: " << clients.size()-num_finished << " clients did not finish" << std::endl;
+	}
+};
+
+
+#endif /* CSIMULATOR_HPP_ */
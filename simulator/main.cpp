@@ -0,0 +1,381 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Description:
+ *
+ * Simulator to evaluate the policies of the world scheduler with a large
+ * number of clients and cores in virtual time (see CSimulator.hpp).
+ *
+ * The clients are either generated with random scalability graphs, work
+ * and arrival times or read from a workload file with one client per line:
+ *
+ *   [arrival time] [max cores] [work of phase 1] [scalability of phase 1] [work of phase 2] ...
+ *
+ * The work is given in seconds on a single core. The scalability of a phase
+ * is one of
+ *   linear, amdahl:[serial fraction], pow2:[efficiency], jump:[cores]
+ * or a comma separated list of the speedups for 1, 2, 3, ... cores.
+ * Lines starting with '#' are ignored.
+ */
+
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "CSimulator.hpp"
+
+
+
+/**
+ * setup the speedup for 1..i_max_cores cores from a scalability description
+ *
+ * \return false if the description is invalid
+ */
+bool setupScalabilityGraph(
+		const std::string &i_description,
+		int i_max_cores,
+		std::vector<float> &o_graph
+)
+{
+	std::string type = i_description.substr(0, i_description.find(':'));
+	double param = 0;
+
+	if (type.size() < i_description.size())
+		param = atof(i_description.c_str()+type.size()+1);
+
+	o_graph.resize(i_max_cores);
+
+	if (type == "linear")
+	{
+		for (int n = 1; n <= i_max_cores; n++)
+			o_graph[n-1] = n;
+	}
+	else if (type == "amdahl")
+	{
+		for (int n = 1; n <= i_max_cores; n++)
+			o_graph[n-1] = 1.0/(param + (1.0-param)/(double)n);
+	}
+	else if (type == "pow2")
+	{
+		// the speedup only increases if the next power of two is reached
+		for (int n = 1; n <= i_max_cores; n++)
+		{
+			int p = 1;
+			while (p*2 <= n)
+				p *= 2;
+
+			o_graph[n-1] = std::pow((double)p, param);
+		}
+	}
+	else if (type == "jump")
+	{
+		// setup overhead until a given number of cores (e.g. a dedicated communication thread)
+		for (int n = 1; n <= i_max_cores; n++)
+			o_graph[n-1] = (n < param ? 1.0 + 0.05*(double)(n-1) : 0.9*(double)n);
+	}
+	else
+	{
+		// comma separated list of speedups
+		o_graph.clear();
+
+		std::istringstream s(i_description);
+		std::string value;
+		while (std::getline(s, value, ','))
+		{
+			char *end;
+			o_graph.push_back(strtod(value.c_str(), &end));
+
+			if (value.empty() || *end != '\0')
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+/**
+ * return a random scalability description of the given type
+ */
+std::string getRandomScalability(
+		const std::string &i_type	///< mixed, linear, amdahl, pow2 or jump
+)
+{
+	std::string type = i_type;
+
+	if (type == "mixed")
+	{
+		const char *types[] = {"amdahl", "pow2", "jump"};
+		type = types[(int)(drand48()*3.0)];
+	}
+
+	std::ostringstream s;
+	s << type;
+
+	if (type == "amdahl")
+		s << ":" << 0.01 + 0.2*drand48();
+	else if (type == "pow2")
+		s << ":" << 0.7 + 0.3*drand48();
+	else if (type == "jump")
+		s << ":" << 2 + (int)(drand48()*8.0);
+
+	return s.str();
+}
+
+
+
+/**
+ * read the clients from a workload file
+ *
+ * \return false if the file is invalid
+ */
+bool loadWorkload(
+		const char *i_path,
+		int i_num_cores,
+		CSimulator &io_cSimulator
+)
+{
+	std::ifstream file(i_path);
+
+	if (!file)
+	{
+		perror(i_path);
+		return false;
+	}
+
+	std::string line;
+	for (int line_nr = 1; std::getline(file, line); line_nr++)
+	{
+		std::istringstream s(line);
+
+		CSimulatedClient c;
+		if (line.empty() || line[0] == '#' || !(s >> c.arrival_timestamp))
+			continue;
+
+		if (!(s >> c.max_cores) || c.max_cores < 1)
+		{
+			std::cerr << i_path << ":" << line_nr << ": invalid number of cores" << std::endl;
+			return false;
+		}
+
+		c.max_cores = std::min(c.max_cores, i_num_cores);
+
+		CSimulatedClient::SPhase phase;
+		std::string scalability;
+
+		while (s >> phase.work)
+		{
+			if (!(s >> scalability) || !setupScalabilityGraph(scalability, c.max_cores, phase.scalability_graph))
+			{
+				std::cerr << i_path << ":" << line_nr << ": invalid scalability" << std::endl;
+				return false;
+			}
+
+			c.phases.push_back(phase);
+		}
+
+		if (c.phases.empty())
+		{
+			std::cerr << i_path << ":" << line_nr << ": no phases" << std::endl;
+			return false;
+		}
+
+		io_cSimulator.addClient(c);
+	}
+
+	return true;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	int num_cores = 1024;
+	int num_clients = 1000;
+	double arrival_rate = 0;
+	int num_phases = 3;
+	double phase_work = 10.0;
+	int max_cores = -1;
+	std::string scalability_type = "mixed";
+	const char *workload_path = nullptr;
+	double message_latency = 10e-6;
+	double checkpoint_interval = 1e-3;
+	int seed = 0;
+	CGlobalOptimizer::EOptimizer optimizer = CGlobalOptimizer::OPTIMIZER_AUTO;
+	double optimizer_time_budget = 0.01;
+	int prediction_plans = 0;
+	int verbose_level = 0;
+	int scheduler_verbose_level = 0;
+
+	char optchar;
+	while ((optchar = getopt(argc, argv, "a:c:g:i:k:l:m:n:o:p:P:s:t:v:V:w:")) > 0)
+	{
+		switch(optchar)
+		{
+		case 'n':
+			num_cores = atoi(optarg);
+			break;
+
+		case 'c':
+			num_clients = atoi(optarg);
+			break;
+
+		case 'a':
+			arrival_rate = atof(optarg);
+			break;
+
+		case 'p':
+			num_phases = atoi(optarg);
+			break;
+
+		case 'w':
+			phase_work = atof(optarg);
+			break;
+
+		case 'm':
+			max_cores = atoi(optarg);
+			break;
+
+		case 'g':
+			scalability_type = optarg;
+			break;
+
+		case 'i':
+			workload_path = optarg;
+			break;
+
+		case 'l':
+			message_latency = atof(optarg);
+			break;
+
+		case 'k':
+			checkpoint_interval = atof(optarg);
+			break;
+
+		case 's':
+			seed = atoi(optarg);
+			break;
+
+		case 'o':
+			if (strcmp(optarg, "auto") == 0)
+				optimizer = CGlobalOptimizer::OPTIMIZER_AUTO;
+			else if (strcmp(optarg, "greedy") == 0)
+				optimizer = CGlobalOptimizer::OPTIMIZER_GREEDY;
+			else if (strcmp(optarg, "dp") == 0)
+				optimizer = CGlobalOptimizer::OPTIMIZER_DP;
+			else
+				goto parameter_error;
+			break;
+
+		case 't':
+			optimizer_time_budget = atof(optarg);
+			break;
+
+		case 'P':
+			prediction_plans = atoi(optarg);
+			break;
+
+		case 'v':
+			verbose_level = atoi(optarg);
+			break;
+
+		case 'V':
+			scheduler_verbose_level = atoi(optarg);
+			break;
+
+		default:
+			goto parameter_error;
+		}
+	}
+
+	if (	scalability_type != "mixed" && scalability_type != "linear" && scalability_type != "amdahl" &&
+			scalability_type != "pow2" && scalability_type != "jump"
+	)
+		goto parameter_error;
+
+	goto parameter_ok;
+
+parameter_error:
+	std::cout << "usage: " << argv[0] << std::endl;
+	std::cout << "	[-n [int]: number of cores, default: 1024]" << std::endl;
+	std::cout << "	[-c [int]: number of clients, default: 1000]" << std::endl;
+	std::cout << "	[-a [float]: arrival rate of the clients per second (Poisson process), default: 0 (all clients arrive at once)]" << std::endl;
+	std::cout << "	[-p [int]: number of phases of each client, default: 3]" << std::endl;
+	std::cout << "	[-w [float]: average work of a phase in seconds on a single core, default: 10]" << std::endl;
+	std::cout << "	[-m [int]: maximum number of cores of each client, default: number of cores]" << std::endl;
+	std::cout << "	[-g [mixed/linear/amdahl/pow2/jump]: scalability graphs of the phases, default: mixed]" << std::endl;
+	std::cout << "	[-i [path]: read the clients from a workload file instead]" << std::endl;
+	std::cout << "	[-l [float]: latency of each message in seconds, default: 10e-6]" << std::endl;
+	std::cout << "	[-k [float]: time between two checkpoints of the clients in seconds, default: 1e-3]" << std::endl;
+	std::cout << "	[-s [int]: seed of the random workload, default: 0]" << std::endl;
+	std::cout << "	[-o [auto/greedy/dp]: solver for the global optimization, default: auto]" << std::endl;
+	std::cout << "	[-t [float]: time budget in seconds for the dynamic programming solver, default: 0.01]" << std::endl;
+	std::cout << "	[-P [int]: precompute up to the given number of solutions of the global optimization for predicted distribution hints]" << std::endl;
+	std::cout << "	[-v [int]: verbosity level of the simulator, default: 0]" << std::endl;
+	std::cout << "	[-V [int]: verbosity level of the world scheduler, default: 0]" << std::endl;
+	return -1;
+
+parameter_ok:
+	if (max_cores <= 0 || max_cores > num_cores)
+		max_cores = num_cores;
+
+	CSimulator cSimulator(num_cores, verbose_level, scheduler_verbose_level);
+
+	cSimulator.message_latency = message_latency;
+	cSimulator.checkpoint_interval = checkpoint_interval;
+
+	cSimulator.getWorldScheduler().setupOptimizer(optimizer, optimizer_time_budget);
+
+	if (prediction_plans > 0)
+		cSimulator.getWorldScheduler().setupPrediction(prediction_plans);
+
+	if (workload_path != nullptr)
+	{
+		if (!loadWorkload(workload_path, num_cores, cSimulator))
+			return -1;
+	}
+	else
+	{
+		srand48(seed);
+
+		double arrival_timestamp = 0;
+
+		for (int i = 0; i < num_clients; i++)
+		{
+			CSimulatedClient c;
+			c.max_cores = max_cores;
+
+			if (arrival_rate > 0)
+				arrival_timestamp += -std::log(1.0-drand48())/arrival_rate;
+
+			c.arrival_timestamp = arrival_timestamp;
+
+			c.phases.resize(num_phases);
+			for (int p = 0; p < num_phases; p++)
+			{
+				c.phases[p].work = phase_work*(0.5+drand48());
+				setupScalabilityGraph(getRandomScalability(scalability_type), max_cores, c.phases[p].scalability_graph);
+			}
+
+			cSimulator.addClient(c);
+		}
+	}
+
+	std::cout << "SIMULATING " << cSimulator.clients.size() << " CLIENTS ON " << num_cores << " CORES" << std::endl;
+
+	cSimulator.run();
+
+	cSimulator.printStatistics();
+
+	return 0;
+}